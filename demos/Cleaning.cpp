@@ -16,6 +16,7 @@ using namespace mc;
 
 class TestComponent: public gfx::Component {
 	void init() override {
+		subscribe(gfx::Event::HOVER);
 	}
 
 	bool update() override {
@@ -102,7 +103,7 @@ int main() {
 		gfx::WindowModule::LaunchConfig config = gfx::WindowModule::LaunchConfig(600, 500, "Cleaning Demo");
 		config.onCreate = &create;
 		config.resizable = true;
-		gfx::WindowModule module = gfx::WindowModule(config);
+		gfx::WindowModule module(config);
 		instance.addModule(module);
 
 		gfx::FPSComponent f = gfx::FPSComponent();
@@ -89,7 +89,7 @@ int main() {
 		gfx::WindowModule::LaunchConfig config = gfx::WindowModule::LaunchConfig(768, 768, "Painting Demo");
 		config.resizable = true;
 
-		gfx::WindowModule module = gfx::WindowModule(config);
+		gfx::WindowModule module(config);
 		instance.addModule(module);
 
 		PainterDemo painterDemo;
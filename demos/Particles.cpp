@@ -0,0 +1,84 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2016 Liav Turkia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+#include <MACE/MACE.h>
+#include <chrono>
+#include <thread>
+#include <iostream>
+
+using namespace mc;
+
+gfx::ParticleEmitter fountain(100000);
+
+//simulating doesn't need a window, so this measures the simulation alone
+void benchmark(const Size particles, const Size threads) {
+	MACE_CONSTEXPR const Size steps = 100;
+
+	gfx::ParticleEmitter emitter(particles);
+	//long enough that no particle dies during the benchmark
+	emitter.setLifetime(1000.0f, 1000.0f);
+	emitter.setVelocity({ -0.5f, 0.5f }, { 0.5f, 1.0f });
+	emitter.setAngularVelocity(-1.0f, 1.0f);
+	emitter.setAcceleration({ 0.0f, -0.98f });
+	emitter.setColor(Colors::WHITE, Colors::INVISIBLE);
+	emitter.setThreadCount(threads);
+	emitter.emit(particles);
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (Index i = 0; i < steps; ++i) {
+		emitter.simulate(1.0f / 60.0f);
+	}
+	const float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << particles << " particles, " << threads << " thread(s): " << milliseconds / steps << " ms per step, ";
+	std::cout << static_cast<float>(particles * steps) / milliseconds << " particles/ms" << std::endl;
+}
+
+void create(gfx::WindowModule& window) {
+	fountain.setEmissionRate(20000.0f);
+	fountain.setLifetime(2.0f, 4.0f);
+	fountain.setVelocity({ -0.3f, 0.8f }, { 0.3f, 1.4f });
+	fountain.setAngularVelocity(-3.0f, 3.0f);
+	fountain.setAcceleration({ 0.0f, -0.98f });
+	fountain.setSize(0.01f, 0.002f);
+	fountain.setColor(Colors::LIGHT_BLUE, Color(0.0f, 0.0f, 1.0f, 0.0f));
+	fountain.setThreadCount(std::thread::hardware_concurrency());
+	fountain.setY(-0.5f);
+
+	window.addChild(fountain);
+}
+
+int main() {
+	benchmark(1000000, 1);
+	benchmark(1000000, std::max<Size>(1, std::thread::hardware_concurrency()));
+
+	Instance instance = Instance();
+	try {
+		gfx::WindowModule::LaunchConfig config = gfx::WindowModule::LaunchConfig(600, 600, "Particles Demo");
+		config.onCreate = &create;
+		config.resizable = true;
+		gfx::WindowModule module(config);
+		instance.addModule(module);
+
+		gfx::FPSComponent f = gfx::FPSComponent();
+		f.setTickCallback([] (gfx::FPSComponent* com, gfx::Entity*) {
+			std::cout << "UPS: " << com->getUpdatesPerSecond() << " FPS: " << com->getFramesPerSecond() << " Particles: " << fountain.getParticleCount() << std::endl;
+		});
+		module.addComponent(f);
+
+		os::ErrorModule errModule = os::ErrorModule();
+		instance.addModule(errModule);
+
+		instance.start();
+	} catch( const std::exception& e ) {
+		Error::handleError(e, instance);
+		return -1;
+	}
+	return 0;
+}
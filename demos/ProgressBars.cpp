@@ -73,7 +73,7 @@ int main() {
 		config.onCreate = &create;
 		config.resizable = true;
 
-		gfx::WindowModule module = gfx::WindowModule(config);
+		gfx::WindowModule module(config);
 		instance.addModule(module);
 
 		os::ErrorModule errModule = os::ErrorModule();
@@ -20,6 +20,8 @@ gfx::Group botLeft, botRight, topLeft, topRight;
 class TestComponent: public gfx::Component {
 
 	void init() override {
+		subscribe(gfx::Event::HOVER);
+
 		dynamic_cast<gfx::Image*>(parent)->getTexture().setHue(Color((rand() % 10) / 10.0f, (rand() % 10) / 10.0f, (rand() % 10) / 10.0f, 0.5f));
 	}
 
@@ -98,7 +100,7 @@ int main() {
 	try {
 		gfx::WindowModule::LaunchConfig config = gfx::WindowModule::LaunchConfig(500, 500, "Rotations Demo");
 		config.onCreate = &create;
-		gfx::WindowModule module = gfx::WindowModule(config);
+		gfx::WindowModule module(config);
 
 		instance.addModule(module);
 
@@ -82,6 +82,7 @@ namespace mc {
 			virtual void unbind() const override = 0;
 
 			virtual void draw() const = 0;
+			virtual void drawInstanced(const Size instances) const = 0;
 
 			virtual void loadTextureCoordinates(const Size dataSize, const float* data) = 0;
 			virtual void loadVertices(const Size verticeSize, const float* vertices) = 0;
@@ -132,6 +133,12 @@ namespace mc {
 			const Enums::PrimitiveType getPrimitiveType() const;
 
 			void draw() const;
+			/**
+			Draws this `Model` multiple times in a single call. Per-instance data must already be bound by the `Renderer`
+			@param instances How many times to draw this `Model`
+			@opengl
+			*/
+			void drawInstanced(const Size instances) const;
 
 			bool isCreated() const;
 
@@ -20,11 +20,129 @@ namespace mc {
 	namespace gfx {
 		using EntityProperties = Byte;
 
+		/**
+		Bitmask of `Event::Type` values that an `Entity` or `Component` has subscribed to.
+		@see Entity::subscribe(const EventMask, const bool)
+		*/
+		using EventMask = Byte;
+
 		//forward-defining dependencies
 		class Entity;
 		class Texture;
 		class Painter;
 
+		/**
+		An input event dispatched by the `EventRouter` to the `Entity` under the mouse.
+		<p>
+		Events travel in 3 phases. First, every ancestor of the target receives it from the root down (`Phase::CAPTURE`). Then the
+		target itself receives it (`Phase::TARGET`), after which it travels back up to the root (`Phase::BUBBLE`). Any handler can
+		call Event::stopPropagation() to end the dispatch.
+		<p>
+		Only entities and components that subscribed to an event's `Type` are given the event. Everything else is skipped without
+		calling any virtual functions.
+		@see Entity::subscribe(const EventMask, const bool)
+		@see Component::subscribe(const EventMask, const bool)
+		*/
+		struct Event {
+			enum Type: EventMask {
+				/**
+				Sent once when the mouse moves onto an `Entity`
+				*/
+				HOVER_ENTER = 0x01,
+				/**
+				Sent once when the mouse moves off of an `Entity`
+				*/
+				HOVER_LEAVE = 0x02,
+				/**
+				Sent every frame that the mouse is over an `Entity`. Calls Entity::onHover() and Component::hover() by default.
+				*/
+				HOVER = 0x04,
+				/**
+				Sent when a mouse button is pressed over an `Entity`
+				@see Event::button
+				*/
+				PRESS = 0x08,
+				/**
+				Sent when a mouse button is released over an `Entity`
+				@see Event::button
+				*/
+				RELEASE = 0x10,
+				/**
+				Sent when the scroll wheel is used over an `Entity`
+				@see Event::scrollX
+				@see Event::scrollY
+				*/
+				SCROLL = 0x20,
+
+				NONE = 0x00,
+				ALL = HOVER_ENTER | HOVER_LEAVE | HOVER | PRESS | RELEASE | SCROLL
+			};//Type
+
+			enum class Phase: Byte {
+				CAPTURE,
+				TARGET,
+				BUBBLE
+			};//Phase
+
+			Type type = Event::NONE;
+			Phase phase = Phase::TARGET;
+
+			/**
+			The `Entity` that was hit by the mouse
+			*/
+			Entity* target = nullptr;
+			/**
+			The `Entity` whose handlers are currently being called
+			*/
+			Entity* currentTarget = nullptr;
+
+			int mouseX = -1, mouseY = -1;
+
+			/**
+			The `Input::Key` of the mouse button for `Event::PRESS` and `Event::RELEASE`
+			*/
+			short int button = -1;
+
+			double scrollX = 0, scrollY = 0;
+
+			/**
+			Stops this `Event` from being dispatched to any more entities.
+			*/
+			void stopPropagation();
+			bool isPropagating() const;
+		private:
+			bool propagating = true;
+		};//Event
+
+		/**
+		Counts how many entities and components are subscribed to at least 1 event, so the `Renderer` knows whether
+		anything needs the `Entity` under the mouse.
+		<p>
+		Copying it does not copy whether it is counted, so copying an `Entity` or `Component` never unbalances the count.
+		@internal
+		*/
+		class SubscriberCounter {
+		public:
+			SubscriberCounter() noexcept = default;
+			SubscriberCounter(const SubscriberCounter& other) noexcept;
+			~SubscriberCounter() noexcept;
+
+			SubscriberCounter& operator=(const SubscriberCounter& other) noexcept;
+
+			/**
+			@param subscribed Whether the owner is now subscribed to any event
+			*/
+			void update(const bool subscribed);
+
+			/**
+			This function is thread safe.
+			@return Whether any `Entity` or `Component` is subscribed to an event
+			*/
+			static bool hasSubscribers();
+		private:
+			bool counted = false;
+		};//SubscriberCounter
+
 		/**
 		Can be plugged into an `Entity` to allow for additional functionality by listening to events. Instead of extending an existing
 		`Entity` subclass, you should prefer using a `Component` to not interfere with custom Entity::onRender() and similar functions.
@@ -79,6 +197,12 @@ namespace mc {
 			*/
 			virtual void destroy() override;
 
+			/**
+			Called when the `Entity` is rendered. This is always called on the rendering thread, even if the `Entity` is
+			recorded on another one, so it may use OpenGL and make entities dirty.
+			@opengl
+			@see Entity::setParallel(const bool)
+			*/
 			virtual void render();
 			/**
 			Called when Entity::clean() is called and it was dirty. This is not required for inheritance.
@@ -87,9 +211,35 @@ namespace mc {
 			virtual void clean();
 
 			/**
+			Called by the default implementation of Component::onEvent(Event&) when it receives `Event::HOVER`
 			@opengl
 			*/
 			virtual void hover();
+
+			/**
+			Called when an `Event` that this `Component` subscribed to is dispatched to it's parent.
+			<p>
+			The default implementation calls Component::hover() for `Event::HOVER`
+			@see Component::subscribe(const EventMask, const bool)
+			@opengl
+			*/
+			virtual void onEvent(Event& e);
+
+			/**
+			Adds event types that this `Component` wants to receive.
+			@param mask Bitmask of `Event::Type`
+			@param capture Whether to receive the events during `Event::Phase::CAPTURE` instead of the target and bubble phases
+			*/
+			void subscribe(const EventMask mask, const bool capture = false);
+			/**
+			@copydoc Component::subscribe(const EventMask, const bool)
+			*/
+			void unsubscribe(const EventMask mask, const bool capture = false);
+
+			bool isSubscribed(const Event& e) const;
+		private:
+			EventMask subscriptions = Event::NONE, captureSubscriptions = Event::NONE;
+			SubscriberCounter subscriberCounter{};
 		};//Component
 
 		/**
@@ -101,6 +251,7 @@ namespace mc {
 		@see Component
 		*/
 		class Entity: public Initializable {
+			friend class Renderer;
 		public:
 			//values defining which bit in a byte every propety is, or how much to bit shift it
 			enum EntityProperty: Byte {
@@ -261,6 +412,17 @@ namespace mc {
 			*/
 			void makeChildrenDirty();
 
+			/**
+			Makes every `Entity` in this tree dirty whose output depends on the size of the window, as defined by
+			Entity::isResizeDependent() const. Unlike Entity::makeChildrenDirty(), entities that look the same at any
+			window size are left clean, so they don't have to recalculate anything.
+			<p>
+			The children of an `Entity` that is made dirty are not checked, as Entity::clean() will clean them along with their parent.
+			@see Entity::MAINTAIN_X
+			@dirty
+			*/
+			void makeResizeDependentsDirty();
+
 			/**
 			Access an `Entity`.
 			<p>
@@ -446,6 +608,7 @@ namespace mc {
 			*/
 			void addComponent(SmartPointer<Component> com);
 			std::vector<SmartPointer<Component>> getComponents();
+			const std::vector<SmartPointer<Component>>& getComponents() const;
 
 			const float& getWidth() const;
 			/**
@@ -550,6 +713,16 @@ namespace mc {
 
 			Metrics getMetrics() const;
 
+			/**
+			Retrieves the transformation from this `Entity's` space to the window, composed with the transformation of every
+			parent. Unlike Entity::getMetrics() const, rotations and scales of every ancestor are applied, no matter how deep
+			the hierarchy is.
+			<p>
+			It is updated when this `Entity` is initialized or cleaned, so it may be outdated while this `Entity` is dirty.
+			@see math::compose(const Vector<float, 3>&, const Vector<float, 3>&, const Vector<float, 3>&)
+			*/
+			const Matrix<float, 4>& getWorldMatrix() const;
+
 			/**
 			@internal
 			@opengl
@@ -558,10 +731,34 @@ namespace mc {
 
 
 			/**
+			Gives an `Event` to this `Entity` and it's components, if they subscribed to it.
+			<p>
+			Calling this function does not propagate the `Event`. The `EventRouter` is responsible for that.
 			@internal
 			@opengl
 			*/
-			virtual void hover();
+			void handleEvent(Event& e);
+
+			/**
+			Adds event types that this `Entity` wants to receive via Entity::onEvent(Event&).
+			<p>
+			An `Entity` that has not subscribed to any events, and has no subscribed components, does no work when it is hovered or clicked.
+			@param mask Bitmask of `Event::Type`
+			@param capture Whether to receive the events during `Event::Phase::CAPTURE` instead of the target and bubble phases
+			@see Entity::unsubscribe(const EventMask, const bool)
+			*/
+			void subscribe(const EventMask mask, const bool capture = false);
+			/**
+			Removes event types from this `Entity's` subscriptions
+			@copydetails Entity::subscribe(const EventMask, const bool)
+			*/
+			void unsubscribe(const EventMask mask, const bool capture = false);
+
+			/**
+			Checks whether this `Entity` or any of it's components will receive an `Event`
+			@param e The `Event` to check for, using it's type and phase
+			*/
+			bool isSubscribed(const Event& e) const;
 
 			/**
 			@dirty
@@ -576,6 +773,43 @@ namespace mc {
 			@dirty
 			*/
 			void makeDirty();
+
+			/**
+			Renders this `Entity` and it's children into a texture once, and draws the texture as a single quad until
+			something in the subtree is made dirty or this `Entity` moves. Useful for complex subtrees that rarely change,
+			like a panel made of many images and text, which would otherwise be drawn again whenever anything else is dirty.
+			<p>
+			The cache is only an optimization. If the `Renderer` doesn't support it, or it's caches are over
+			WindowModule::LaunchConfig::renderCacheBudget, the subtree is rendered normally instead. Entities behind the
+			transparent parts of a cached subtree can't be picked.
+			@dirty
+			*/
+			void setCached(const bool cached);
+			bool isCached() const;
+
+			/**
+			Records the draws of this `Entity` and it's children on another thread, while the rendering thread records the
+			rest of the tree. Useful for large subtrees, like thousands of sprites, whose draws would otherwise be recorded
+			one at a time on the rendering thread. They are still drawn in the same order.
+			<p>
+			The subtree is initialized and cleaned on the rendering thread first, and Component::render() is called there
+			too, before the subtree is recorded. Only Entity::onRender() is called on the other thread, while the rendering
+			thread reads the rest of the tree. It must not call OpenGL or make anything dirty, so entities that create
+			textures or models while rendering can't be in the subtree. Entities in the subtree are never cached.
+			<p>
+			If the `Renderer` doesn't support it, or there is a subtree being recorded on every core already, the subtree is
+			recorded on the rendering thread instead.
+			@see Entity::setCached(const bool)
+			*/
+			void setParallel(const bool parallel);
+			bool isParallel() const;
+
+			/**
+			Retrieves how many times this `Entity` has been made dirty. If it is the same as the last time it was rendered,
+			it would render the same thing again.
+			@see Entity::makeDirty()
+			*/
+			Size getRevision() const;
 		protected:
 			/**
 			`std::vector` of this `Entity\'s` children. Use of this variable directly is unrecommended. Use `addChild()` or `removeChild()` instead.
@@ -658,15 +892,55 @@ namespace mc {
 			virtual void onClean();
 
 			/**
+			Called on the root `Entity` when Entity::makeDirty() makes the tree dirty. This can be called from any thread.
+			*/
+			virtual void onDirty();
+
+			/**
+			Called by the default implementation of Entity::onEvent(Event&) when it receives `Event::HOVER`
 			@internal
 			@opengl
 			*/
 			virtual void onHover();
+
+			/**
+			Called when an `Event` this `Entity` has subscribed to is dispatched to it.
+			<p>
+			The default implementation calls Entity::onHover() for `Event::HOVER`
+			@see Entity::subscribe(const EventMask, const bool)
+			@internal
+			@opengl
+			*/
+			virtual void onEvent(Event& e);
+
+			/**
+			Whether this `Entity` needs to be cleaned again when the window is resized.
+			<p>
+			By default, this is `true` if any of the `Entity::MAINTAIN_X`, `Entity::MAINTAIN_Y`, `Entity::MAINTAIN_WIDTH`,
+			or `Entity::MAINTAIN_HEIGHT` flags are set, as Entity::getMetrics() const uses the window ratios for them. Override
+			this if the output of onClean() is sized in pixels some other way.
+			@see Entity::makeResizeDependentsDirty()
+			*/
+			virtual bool isResizeDependent() const;
 		private:
 			std::vector<SmartPointer<Component>> components = std::vector<SmartPointer<Component>>();
 
 			EntityProperties properties = Entity::DEFAULT_PROPERTIES;
 
+			EventMask subscriptions = Event::NONE, captureSubscriptions = Event::NONE;
+			SubscriberCounter subscriberCounter{};
+
+			//identifies the render cache of this entity, or 0 if it isn't cached
+			Index cacheID = 0;
+			//whether anything in the subtree was made dirty since it was last rendered
+			bool cacheStale = true;
+
+			Size revision = 0;
+
+			Matrix<float, 4> worldMatrix = math::identity<float, 4>();
+
+			bool parallel = false;
+
 			Entity* parent = nullptr;
 
 			/**
@@ -677,6 +951,24 @@ namespace mc {
 			void kill();
 
 			void setParent(Entity* parent);
+
+			/**
+			Composes Entity::getWorldMatrix() const from the world matrix of the parent, which has to be up to date.
+			@opengl
+			*/
+			void updateWorldMatrix();
+
+			/**
+			Initializes and cleans the subtree like Entity::render() would, and calls Component::render(), without rendering
+			the entities
+			@opengl
+			*/
+			void prepare();
+			/**
+			Calls Entity::onRender() on the subtree after Entity::prepare(), which can be done on a thread without a
+			`Renderer` context.
+			*/
+			void record();
 		};//Entity
 
 		class Group: public Entity {
@@ -361,8 +361,13 @@ namespace mc {
 			void onUpdate() override;
 			void onRender(Painter& p) override;
 			void onDestroy() override;
-			void onHover() override;
+			void onEvent(Event& e) override;
 			void onClean() override;
+
+			//the textures that are drawn depend on the state, so changing it makes the Button dirty
+			void onClick() override;
+			void onEnable() override;
+			void onDisable() override;
 		private:
 			Texture texture;
 			Texture hoverTexture;
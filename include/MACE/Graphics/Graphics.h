@@ -49,5 +49,8 @@ namespace mc {
 #include <MACE/Graphics/Renderer.h>
 #include <MACE/Graphics/Context.h>
 #include <MACE/Graphics/Window.h>
+#include <MACE/Graphics/Scene.h>
+#include <MACE/Graphics/Particles.h>
+#include <MACE/Graphics/TileMap.h>
 
 #endif
\ No newline at end of file
@@ -23,11 +23,23 @@ The above copyright notice and this permission notice shall be included in all c
 
 #include <GL/glew.h>
 
+#include <atomic>
 #include <unordered_map>
 #include <vector>
 
 #define MACE__VAO_DEFAULT_VERTICES_LOCATION 0
 #define MACE__VAO_DEFAULT_TEXTURE_COORD_LOCATION 1
+#define MACE__VAO_INSTANCE_TRANSFORM_LOCATION 2
+#define MACE__VAO_INSTANCE_COLOR_LOCATION 3
+//batched and instanced draws never use the same shader, so their locations can overlap
+//a mat4 attribute takes up 4 locations, 1 for each column
+#define MACE__VAO_BATCH_MATRIX_LOCATION 2
+#define MACE__VAO_BATCH_FOREGROUND_COLOR_LOCATION 6
+#define MACE__VAO_BATCH_FOREGROUND_TRANSFORM_LOCATION 7
+#define MACE__VAO_BATCH_MASK_COLOR_LOCATION 8
+#define MACE__VAO_BATCH_MASK_TRANSFORM_LOCATION 9
+#define MACE__VAO_BATCH_ENTITY_ID_LOCATION 10
+#define MACE__VAO_BATCH_DEPTH_LOCATION 11
 
 namespace mc {
 	namespace gfx {
@@ -70,14 +82,78 @@ namespace mc {
 			MACE__DECLARE_ERROR(Framebuffer);
 
 			/**
+			How ogl::checkGLError(const Index, const char*, const char*) finds OpenGL errors. glGetError() can force the
+			driver to wait for the GPU, so checking after every call is slow.
+			@see setErrorCheckMode(const ErrorCheckMode)
+			*/
+			enum class ErrorCheckMode: Byte {
+				/**
+				checkGLError() does nothing. forceCheckGLError() still checks.
+				<p>
+				The default if MACE_DEBUG_OPENGL is not defined.
+				*/
+				NONE = 0,
+				/**
+				checkGLError() calls glGetError() and throws any errors right away.
+				<p>
+				The default if MACE_DEBUG_OPENGL is defined.
+				*/
+				IMMEDIATE = 1,
+				/**
+				checkGLError() only remembers where it was called. Errors are found by forceCheckGLError(), which the
+				`Renderer` calls once per frame, and are reported with the last place checkGLError() was called.
+				*/
+				DEFERRED = 2,
+				/**
+				OpenGL reports errors to a GL_KHR_debug callback as they happen, and they are thrown by the next call to
+				checkGLError() or forceCheckGLError() on the same thread, along with the last place checkGLError() was
+				called. glGetError() is never called. Falls back to ErrorCheckMode::DEFERRED if GL_KHR_debug isn't supported.
+				*/
+				DEBUG_CALLBACK = 3
+			};
+
+			/**
+			Changes how OpenGL errors are checked. Can be called from any thread at any time, and takes effect on each
+			thread with a context the next time it checks for errors.
+			*/
+			void setErrorCheckMode(const ErrorCheckMode mode);
+			ErrorCheckMode getErrorCheckMode();
+
+			/**
+			The current `ErrorCheckMode`, which is only declared here so checkGLError() can be inlined.
+			@internal
+			@see setErrorCheckMode(const ErrorCheckMode)
+			*/
+			extern std::atomic<ErrorCheckMode> errorCheckMode;
+
+			/**
+			Called by checkGLError() unless the `ErrorCheckMode` is ErrorCheckMode::NONE.
+			@internal
+			@opengl
+			*/
+			void checkGLErrorImpl(const Index line, const char* file, const char* message);
+
+			/**
+			Checks for OpenGL errors according to the current `ErrorCheckMode`. With ErrorCheckMode::NONE, this is a single
+			load, so it can be called after every OpenGL call.
+			@see forceCheckGLError(const Index, const char*, const char*)
 			@opengl
 			*/
-			void checkGLError(const Index line = 0, const char* file = "Unknown file", const char* message = "No message specified");
+			inline void checkGLError(const Index line = 0, const char* file = "Unknown file", const char* message = "No message specified") {
+				if (errorCheckMode.load(std::memory_order_relaxed) != ErrorCheckMode::NONE) {
+					checkGLErrorImpl(line, file, message);
+				}
+			}
 			/**
 			@copydoc ogl::checkGLError(const Index, const char*, const char*)
 			*/
 			void checkGLError(const Index line, const char* file, const std::string message);
 
+			/**
+			Throws every OpenGL error that happened, regardless of the `ErrorCheckMode`. With ErrorCheckMode::DEBUG_CALLBACK
+			the errors reported to the callback are thrown instead.
+			@opengl
+			*/
 			void forceCheckGLError(const Index line, const char* file, const char* message);
 
 			/**
@@ -93,12 +169,44 @@ namespace mc {
 			@opengl
 			*/
 			void setBlending(const Enum sfactor, const Enum dfactor);
+			/**
+			Blends the alpha channel with different factors than the color channels
+			@opengl
+			*/
+			void setBlending(const Enum sourceColor, const Enum destinationColor, const Enum sourceAlpha, const Enum destinationAlpha);
 
 			/**
 			@opengl
 			*/
 			void setViewport(const Index x, const Index y, const Size width, const Size height);
 
+			/**
+			How many state changes the ogl:: wrappers sent to OpenGL, and how many they skipped because the state was
+			already set.
+			<p>
+			Every thread keeps a shadow copy of the programs, buffers, vertex arrays, textures, enabled capabilities,
+			and blending function that it bound, as each thread has it's own context. Binds and state changes that
+			wouldn't change the shadow copy are never sent to OpenGL.
+			@see getStateCounters()
+			*/
+			struct StateCounters {
+				Size issued = 0;
+				Size skipped = 0;
+			};
+
+			/**
+			@return The counters of the calling thread since the last call to resetStateCounters()
+			*/
+			const StateCounters& getStateCounters();
+			void resetStateCounters();
+
+			/**
+			Forgets the shadowed state of the calling thread, so the next binds are always sent to OpenGL. Must be called
+			when a new context is made current, or when OpenGL state is changed without the ogl:: wrappers.
+			@see StateCounters
+			*/
+			void invalidateStateCache();
+
 			/**
 			Represents a OpenGL object in memory. All abstractions for OpenGL objects override this.
 			<p>
@@ -1118,6 +1226,32 @@ namespace mc {
 				*/
 				void link();
 
+				/**
+				Whether the driver can save linked programs with ShaderProgram::getBinary(Enum&) const and load them
+				again with ShaderProgram::loadBinary(const Enum, const Byte*, const Size)
+				@opengl
+				*/
+				static bool isBinarySupported();
+
+				/**
+				Hints to the driver that the binary of this program will be retrieved. Must be called before ShaderProgram::link()
+				@opengl
+				*/
+				void setBinaryRetrievable(const bool retrievable);
+				/**
+				@param format Where the driver specific format of the binary is stored
+				@return The linked program, or an empty vector if binaries aren't supported
+				@opengl
+				*/
+				std::vector<Byte> getBinary(Enum& format) const;
+				/**
+				Loads a binary retrieved with ShaderProgram::getBinary(Enum&) const instead of linking shaders. The driver
+				rejects binaries from other drivers or driver versions.
+				@return Whether the program was loaded. If it wasn't, it has to be linked from source.
+				@opengl
+				*/
+				bool loadBinary(const Enum format, const Byte* data, const Size length);
+
 				bool isCreated() const override;
 
 				/**
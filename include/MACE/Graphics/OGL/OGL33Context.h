@@ -28,6 +28,7 @@ namespace mc {
 				void unbind() const override;
 
 				void draw() const override;
+				void drawInstanced(const Size instances) const override;
 
 				void loadTextureCoordinates(const Size dataSize, const float* data) override;
 				void loadVertices(const Size verticeSize, const float* vertices) override;
@@ -13,7 +13,25 @@ The above copyright notice and this permission notice shall be included in all c
 
 #include <MACE/Graphics/Renderer.h>
 #include <MACE/Graphics/OGL/OGL.h>
+#include <MACE/Graphics/Context.h>
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//how many frames of painter data can be in flight before the CPU waits for the GPU
+#define MACE__PAINTER_DATA_FRAMES 3
+//how many picking readbacks can be in flight before new ones are skipped
+#define MACE__PICKING_BUFFERS 3
+//how many frames can be timed on the GPU at once
+#define MACE__GPU_TIMER_QUERIES 3
 
 namespace mc {
 	namespace gfx {
@@ -33,29 +51,37 @@ namespace mc {
 
 				void clean() override;
 			protected:
-				void loadSettings(const Painter::State& state) override;
+				void loadSettings(const Painter::State& state, const Painter::StateFields changed) override;
+				void bindTexture(const Texture& t, const Enums::TextureSlot slot) override;
 				void draw(const Model& m, const Enums::Brush brush, const Enums::RenderFeatures feat) override;
+				void drawInstanced(const Model& m, const Enums::Brush brush, const Enums::RenderFeatures feat, const InstanceData* instances, const Size count) override;
 			private:
 				OGL33Renderer* const renderer;
 
-				UniformBuffer painterData;
-				UniformBuffer entityData;
+				//the world matrix of the entity that was last given to the renderer
+				Matrix<float, 4> savedWorldMatrix;
 
-				Entity::Metrics savedMetrics;
-				Painter::State savedState;
+				//the state given to loadSettings(), which is copied into the draw command
+				const Painter::State* currentState = nullptr;
+				//fields that changed since the state was last copied into a command list
+				Painter::StateFields changedFields = Painter::ALL_FIELDS;
+				//where the state was last copied to. if nothing changed since, draws in the same list share it
+				Index stateFrame = 0, stateList = 0, stateSlot = 0;
 
-				void createEntityData();
-				void createPainterData();
+				std::array<Texture, 3> textures{};
 			};
 
 			/**
-			@todo Remove discard from Frag.glsl
+			Draws are recorded while the entities render, and replayed at the end of the frame in 2 passes. Opaque draws
+			are drawn first, front to back with depth writes and without blending. Everything else is blended back to
+			front afterwards, depth tested against the opaque draws, so the GPU never shades what an opaque draw covers.
+			@see Enums::RenderFeatures::FULLY_OPAQUE
 			*/
 			class OGL33Renderer: public Renderer {
 				friend class OGL33Painter;
 			public:
 				OGL33Renderer();
-				~OGL33Renderer() noexcept override = default;
+				~OGL33Renderer() noexcept override;
 
 				void onResize(gfx::WindowModule* win, const Size width, const Size height) override;
 				void onInit(gfx::WindowModule* win) override;
@@ -68,7 +94,18 @@ namespace mc {
 
 				GraphicsEntity* getEntityAt(const int x, const int y) override;
 
+				/**
+				@return Whether a picking readback is still in flight
+				*/
+				bool hasPendingResults() const override;
+
 				std::shared_ptr<PainterImpl> createPainterImpl(Painter* const p) override;
+			protected:
+				bool onBeginCache(Entity* en, const Index id, const bool stale) override;
+				void onEndCache(Entity* en, const Index id) override;
+
+				void onRecordParallel(Entity* en) override;
+				void onFinishRecording() override;
 			private:
 				ogl::FrameBuffer frameBuffer{};
 				ogl::RenderBuffer depthBuffer{};
@@ -77,17 +114,514 @@ namespace mc {
 
 				Color clearColor = Colors::BLACK;
 
+				/*
+				ring of pixel pack buffers that the pixel under the mouse is copied into. a copy is only read once it's fence
+				is signaled, so getEntityAt() never waits for the GPU, and returns what was under the mouse a frame or 2 ago
+				*/
+				std::array<ogl::PixelPackBuffer, MACE__PICKING_BUFFERS> pickingBuffers{};
+				std::array<GLsync, MACE__PICKING_BUFFERS> pickingFences{};
+				//Renderer::frameCount of the frame each copy was made from
+				std::array<Size, MACE__PICKING_BUFFERS> pickingFrames{};
+				//the next buffer to copy into, which is also the oldest copy in flight
+				Index pickingIndex = 0;
+				//the entity in the newest copy that was read
+				EntityID pickedEntity = 0;
+				Size pickedFrame = 0;
+				int pickingX = -1, pickingY = -1;
+				//whether the id texture changed since the last copy
+				bool pickingStale = true;
+
+				//GL_TIME_ELAPSED queries for the last frames, read once their results are available so the CPU never waits
+				std::array<ogl::QueryObject, MACE__GPU_TIMER_QUERIES> gpuTimers{};
+				std::array<bool, MACE__GPU_TIMER_QUERIES> gpuTimersPending{};
+				//the timer for the next frame, which is also the oldest one that may be pending
+				Index gpuTimerIndex = 0;
+				//whether the frame being rendered is timed
+				bool timingFrame = false;
+				//in milliseconds, from the newest timer that was read
+				float lastGPUTime = 0.0f;
+				//whether lastGPUTime changed this frame
+				bool gpuTimeUpdated = false;
+
+				/*
+				the framebuffer is always allocated at the full size of the window, and scaled frames only draw to the
+				bottom left part of it, so changing the scale never reallocates anything
+				*/
+				int framebufferWidth = 1, framebufferHeight = 1;
+				float renderScale = 1.0f;
+				//consecutive GPU timings over or under the budget, so a single slow frame doesn't change the scale
+				Size framesOverBudget = 0, framesUnderBudget = 0;
+				//timings still in flight from before the scale changed, which are ignored
+				Size staleGPUTimings = 0;
+				//whether this frame is drawn to frameBuffer instead of the window, which it is if it needs picking or is scaled
+				bool offscreen = false;
+				//the size of the viewport of the frame, in pixels
+				int sceneWidth = 1, sceneHeight = 1;
+
+
+				/**
+				Everything a batched `Model::getQuad()` draw would have gotten from the uniform buffers of it's painter.
+				Each quad in a batch is 1 instance, so quads from different entities and painter states can be drawn together.
+				*/
+				struct QuadInstance {
+					//the painter transformation times the world matrix of the entity
+					float matrix[16];
+					float foregroundColor[4];
+					float foregroundTransform[4];
+					float maskColor[4];
+					float maskTransform[4];
+					GLuint entityID;
+					//see DrawCommand::depth
+					float depth;
+				};
+
+				//what every quad in the current batch has in common
+				struct BatchKey {
+					Enums::Brush brush;
+					Enums::RenderFeatures features;
+					std::array<Texture, 3> textures;
+					Matrix<float, 4, 4> filter;
+					//a state with the filter of the batch
+					Index painterDataSlot;
+				};
+
+				//axis aligned box in normalized device coordinates
+				struct DrawBounds {
+					float left, bottom, right, top;
+				};
+
+				struct RenderCache;
+
+				/**
+				A draw recorded by a painter. Draws are replayed at the end of the frame, sorted by `key`
+				*/
+				struct DrawCommand {
+					/*
+					from most to least significant: 1 bit of pass, 31 bits of layer, 16 bits of program, and 16 bits of
+					texture set. draws on the same layer don't overlap, so only the layer has to be sorted for blending to
+					be correct. opaque draws have their layers reversed so they are drawn front to back. it is only set once
+					the command lists are merged, as the layer depends on every draw before it
+					*/
+					std::uint64_t key = 0;
+					//whether the draw is in the opaque pass. only draws into the scene can be, as caches have no depth buffer
+					bool opaque = false;
+					//the depth the draw is drawn at, which is smaller for every draw after it, so the depth test keeps the order
+					float depth = 0.0f;
+					DrawBounds bounds{};
+
+					Enums::Brush brush = Enums::Brush::COLOR;
+					Enums::RenderFeatures features = Enums::RenderFeatures::NONE;
+					std::array<Texture, 3> textures{};
+					Matrix<float, 4, 4> filter;
+					EntityID entity = 0;
+
+					//if it is batched, the draw is in batchedQuads instead of having a model and painter data
+					bool batched = false;
+					Index quad = 0;
+
+					Model model{};
+					Index painterDataSlot = 0;
+
+					//only set if the draw is instanced
+					Index instanceOffset = 0;
+					Size instanceCount = 0;
+
+					//if it is set, the draw is the texture of a cache instead
+					const RenderCache* cache = nullptr;
+					//see cacheTargets
+					Index target = 0;
+				};
+
+				/**
+				Draws recorded by 1 thread. Everything in a list is indexed from the start of the list, and becomes part of
+				the frame once the lists are merged in the order they were created.
+				*/
+				struct CommandList {
+					std::vector<DrawCommand> commands{};
+					std::vector<QuadInstance> quads{};
+					std::vector<InstanceData> instances{};
+					//the painter data slot of an unbatched command is an index in this until it is merged
+					std::vector<Painter::State> states{};
+
+					//the index of this list in commandLists
+					Index index = 0;
+
+					//for lists recorded on another thread, which can't use the cache stack
+					Index target = 0;
+					DrawBounds bounds{};
+					std::exception_ptr error{};
+				};
+
+				/*
+				the lists of this frame, in draw order. every subtree recorded on another thread gets a list, and the
+				rendering thread starts a new list after it, so the draws after the subtree stay after it. lists are
+				reused between frames so their memory is too
+				*/
+				std::vector<std::unique_ptr<CommandList>> commandLists{};
+				Size usedCommandLists = 0;
+				//the list the rendering thread is recording into
+				Index currentList = 0;
+				/*
+				threads that record subtrees, kept between frames as starting them every frame would cost more than most
+				subtrees take to record. each queued subtree is taken by whichever worker is free
+				*/
+				struct PendingRecording {
+					Entity* entity;
+					CommandList* list;
+					WindowModule* window;
+				};
+				std::vector<std::thread> recordingWorkers{};
+				std::mutex recordingMutex;
+				std::condition_variable recordingStart{}, recordingFinish{};
+				std::deque<PendingRecording> pendingRecordings{};
+				//subtrees that were queued and haven't finished recording
+				Size unfinishedRecordings = 0;
+				bool stoppingRecording = false;
+				//subtrees queued since the rendering thread last waited for them. only used by the rendering thread
+				Size queuedRecordings = 0;
+				//the list of a thread recording a subtree, or nullptr on the rendering thread
+				static thread_local CommandList* recordingList;
+
+				//the merged command lists
+				std::vector<DrawCommand> commands{};
+				std::vector<QuadInstance> batchedQuads{};
+				std::vector<InstanceData> frameInstances{};
+				//the combined bounds of every draw on each layer, with separate layers for the opaque pass
+				std::vector<DrawBounds> layerBounds{}, opaqueLayerBounds{};
+				std::map<std::array<const void*, 3>, Size> textureSets{};
+				std::vector<std::pair<std::uint64_t, Index>> sortedCommands{}, sortScratch{};
+
+				/**
+				A subtree rendered into a texture, with the entity IDs it wrote for picking.
+				@see Entity::setCached(const bool)
+				*/
+				struct RenderCache {
+					ogl::FrameBuffer frameBuffer{};
+					ogl::Texture2D colorTexture{}, idTexture{};
+					//the part of the scene the textures cover, in pixels. the textures are only as big as what was drawn
+					int x = 0, y = 0, width = 0, height = 0;
+					//the scene it was rendered for. if the window or render scale changes, it has to be rendered again
+					int sceneWidth = 0, sceneHeight = 0;
+					//where the cached entity was. it's children are drawn relative to it, so if it moves, it has to be rendered again
+					Entity::Metrics metrics{};
+					bool valid = false;
+					Index lastUsed = 0;
+				};
+
+				//a cache being rendered this frame
+				struct CacheTarget {
+					RenderCache* cache;
+					//the combined bounds of every draw into the cache
+					DrawBounds bounds;
+				};
+
+				std::map<Index, RenderCache> renderCaches{};
+				//bytes used by every cache texture
+				Size renderCacheMemory = 0;
+				Index frameNumber = 0;
+
+				//commands are drawn into cacheTargets[target - 1], or the scene if target is 0
+				std::vector<CacheTarget> cacheTargets{};
+				//targets of the caches currently being recorded, innermost last
+				std::vector<Index> cacheStack{};
+				//the target being drawn to while submitting
+				Index boundTarget = 0;
+				//whether the blending and depth writes of the opaque pass are bound
+				bool opaquePass = false;
+
+				//what was last bound while replaying commands, so binding it again can be skipped
+				std::array<const void*, 3> boundTextures{};
+				Index boundPainterData = 0;
+
+				/*
+				ring buffer of painter states. it is split into MACE__PAINTER_DATA_FRAMES parts, and each frame writes to the
+				next part, after waiting for the fence of the frame that last used it. every state is written to a new slot,
+				so the GPU is never reading what the CPU is writing
+				*/
+				ogl::UniformBuffer painterData{};
+				//persistently mapped pointer to painterData if ARB_buffer_storage is supported, or nullptr if it isn't
+				Byte* mappedPainterData = nullptr;
+				//the states of this frame if painterData isn't mapped, uploaded together once they are all written
+				std::vector<Byte> painterDataStaging{};
+				std::array<GLsync, MACE__PAINTER_DATA_FRAMES> painterDataFences{};
+				//in bytes, aligned to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+				Size painterDataStride = 0;
+				//how many states can be written every frame
+				Size painterDataCapacity = 0;
+				Index painterDataFrame = 0;
+				//how many states were written this frame
+				Index painterDataCursor = 0;
+				//the painter data slots of the states of the command list being merged
+				std::vector<Index> mergedStates{};
+				//the slot of a default state written this frame
+				Index defaultPainterDataSlot = 0;
+
+				/*
+				entity data for every painter, indexed by EntityID - 1. each entity is entityDataStride floats apart
+				so it's offset satisfies GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, and is bound with glBindBufferRange
+				*/
+				ogl::UniformBuffer entityData{};
+				std::vector<float> entityDataStorage{};
+				std::vector<bool> dirtyEntities{};
+				Size dirtyEntityCount = 0;
+				Size entityDataStride = 0;
+				//how many entities the GPU buffer can hold
+				Size entityDataCapacity = 0;
+				EntityID boundEntity = 0;
+
+				std::vector<QuadInstance> batchInstances{};
+				BatchKey batchKey{};
+
+				//a copy of the quad with the instance attributes attached
+				ogl::VertexArray batchArray{};
+				ogl::VertexBuffer batchVertices{};
+				ogl::ElementBuffer batchIndices{};
+				ogl::VertexBuffer batchInstanceBuffer{};
+				Model quad{};
+
+				//streamed every instanced draw, shared between every painter
+				ogl::VertexBuffer instanceBuffer{};
+				Size instanceCapacity = 0;
+
 				void generateFramebuffer(const int width, const int height);
 
+				/**
+				Reads every finished GPU timer and starts timing the frame, unless every timer is still pending
+				@opengl
+				*/
+				void beginGPUTimer();
+				void endGPUTimer();
+				/**
+				Lowers the render scale if the GPU keeps going over the budget, and raises it once it keeps staying well
+				under it.
+				*/
+				void updateRenderScale();
+				/**
+				@return `size` multiplied by the render scale, rounded
+				*/
+				int getScaledSize(const int size) const;
+
+				void createPickingBuffers();
+				void destroyPickingBuffers();
+				/**
+				Reads every picking copy that the GPU has finished, without waiting for the rest.
+				@opengl
+				*/
+				void readPickingBuffers();
+				/**
+				Copies the pixel at `x` and `y` of the id texture into the next picking buffer.
+				@return Whether it was copied. It isn't if every picking buffer is still in flight.
+				@opengl
+				*/
+				bool requestPick(const int x, const int y);
+
+				void createUniformBuffers();
+				void destroyUniformBuffers();
+
+				/**
+				Stores the entity data of a painter. It is uploaded with the rest of the changed entities at the start of
+				the next frame, or before the entity is drawn, whichever comes first.
+				*/
+				void setEntityData(const EntityID id, const Matrix<float, 4>& worldMatrix);
+				/**
+				Uploads every changed entity, merging neighbouring entities into 1 upload.
+				@opengl
+				*/
+				void uploadEntityData();
+				/**
+				Binds the part of the entity buffer belonging to an entity, if it isn't already bound.
+				@opengl
+				*/
+				void bindEntityData(const EntityID id);
+				/**
+				@param capacity How many states can be written every frame
+				@opengl
+				*/
+				void createPainterData(const Size capacity);
+				void destroyPainterData();
+				/**
+				Moves to the next part of the painter data ring buffer, waiting if the GPU is still using it.
+				@opengl
+				*/
+				void beginPainterDataFrame();
+				/**
+				Fences the part of the painter data ring buffer written this frame.
+				@opengl
+				*/
+				void endPainterDataFrame();
+				/**
+				Doubles the size of the painter data ring buffer, keeping the states written this frame.
+				@opengl
+				*/
+				void growPainterData();
+				/**
+				Writes `state` to a new slot in the painter data ring buffer. Draws that share a state share it's slot instead
+				of writing it again, so this never compares states.
+				<p>
+				Every state of a frame is written while the command lists are merged, before uploadPainterData().
+				@return The slot `state` is in
+				@opengl
+				*/
+				Index writePainterData(const Painter::State& state);
+				/**
+				Uploads the states written this frame with 1 mapping, unless painterData is persistently mapped.
+				@opengl
+				*/
+				void uploadPainterData();
+				/**
+				@param slot A slot returned by writePainterData(const Painter::State&) this frame
+				@opengl
+				*/
+				void bindPainterData(const Index slot);
+
+				void createBatchBuffers();
+				void destroyBatchBuffers();
+
+				/**
+				Whether a draw can be combined with other draws instead of being drawn on it's own
+				*/
+				bool canBatch(const Model& m, const Enums::Brush brush);
+				/**
+				Records a draw to be sorted and replayed at the end of the frame. Every state the draw depends on is
+				copied, so the painter can change right after.
+				@param instances Per-instance data for an instanced draw, or nullptr for a normal draw
+				*/
+				void recordDraw(OGL33Painter* painter, const Model& m, const Enums::Brush brush, const Enums::RenderFeatures feat, const InstanceData* instances, const Size count);
+				/**
+				Starts a new command list at the end of the frame
+				@return The index of the list
+				*/
+				Index beginCommandList();
+				/**
+				Waits for every subtree being recorded on another thread, adding the bounds of what they drew to their cache
+				targets. Exceptions thrown while recording are kept in their lists.
+				*/
+				void waitForRecordings();
+				void runRecordingWorker();
+				void stopRecordingWorkers();
+				/**
+				Combines the command lists of this frame in order, deciding the layer of every draw and writing their painter data.
+				@opengl
+				*/
+				void mergeCommandLists();
+				/**
+				@param layers The combined bounds of each layer, which `bounds` is added to
+				@return The lowest layer that is above every layer that `bounds` overlaps
+				*/
+				Index getLayer(const DrawBounds& bounds, std::vector<DrawBounds>& layers);
+				QuadInstance createQuadInstance(const OGL33Painter* painter, const Painter::State& state) const;
+				DrawBounds getQuadBounds(const QuadInstance& instance) const;
+				/**
+				Sorts every recorded draw and draws them, skipping binds that wouldn't change anything.
+				@opengl
+				*/
+				void submitCommands();
+				/**
+				Binds the framebuffer, viewport and blending of a draw target
+				@param target 0 for the scene, or 1 more than the index in cacheTargets
+				@opengl
+				*/
+				void bindTarget(const Index target);
+				/**
+				Switches between the opaque pass, which writes depth without blending, and the transparent pass, which
+				blends without writing depth. Both are depth tested.
+				@opengl
+				*/
+				void bindPass(const bool opaque);
+				/**
+				Draws the texture of a cache into the bound target, and copies it's entity IDs if picking is enabled.
+				@opengl
+				*/
+				void drawCache(const RenderCache& cache, const float depth);
+				/**
+				Records a draw of a cache into the target currently being recorded
+				*/
+				void recordCache(const RenderCache& cache);
+				/**
+				Creates the textures of a cache if they are missing or the wrong size, deleting the least recently used
+				caches until they fit in the budget.
+				@return Whether the cache has textures to render into
+				@opengl
+				*/
+				bool allocateCache(RenderCache& cache, const int width, const int height);
+				void destroyCache(RenderCache& cache);
+				/**
+				Binds the textures used by `brush` that aren't already bound
+				@opengl
+				*/
+				void bindTextures(const Enums::Brush brush, const std::array<Texture, 3>& textures);
+				/**
+				Adds a batched draw to the current batch, flushing it first if the quad can't be combined with it
+				*/
+				void batchQuad(const DrawCommand& command);
+				/**
+				Draws every quad in the current batch.
+				@return Whether anything was drawn
+				@opengl
+				*/
+				bool flushBatch();
+
+				/**
+				Uploads per-instance data and attaches it to the currently bound `VertexArray`
+				@opengl
+				*/
+				void bindInstances(const InstanceData* instances, const Size count);
+				/**
+				Detaches the per-instance data from the currently bound `VertexArray`
+				@opengl
+				*/
+				void unbindInstances();
+
 				//for the Painter
 
 				struct RenderProtocol {
 					ogl::ShaderProgram program;
+					//unbatched draws get their depth from a uniform, as their painter data can be shared with other draws
+					int depthLocation = -1;
 				};
 
 				std::map<std::pair<Enums::Brush, Enums::RenderFeatures>, OGL33Renderer::RenderProtocol> protocols{};
 
-				void bindProtocol(OGL33Painter* painter, const std::pair<Enums::Brush, Enums::RenderFeatures> settings);
+				const RenderProtocol* boundProtocol = nullptr;
+				std::pair<Enums::Brush, Enums::RenderFeatures> boundSettings{};
+
+				void bindProtocol(const std::pair<Enums::Brush, Enums::RenderFeatures> settings);
+				/**
+				Creates the program for `settings` and binds it's uniform blocks
+				@opengl
+				*/
+				RenderProtocol& createProtocol(const std::pair<Enums::Brush, Enums::RenderFeatures> settings);
+				/**
+				Loads the program for `settings` from the shader cache, or compiles it if it isn't cached or the driver rejects it
+				@opengl
+				*/
+				ogl::ShaderProgram createProgram(const std::pair<Enums::Brush, Enums::RenderFeatures> settings);
+				/**
+				Creates the programs that are likely to be used and every program in the shader cache, so the first
+				frames don't stall compiling them.
+				@opengl
+				*/
+				void warmUpProtocols();
+
+				struct ProgramBinary {
+					//hash of the GLSL it was compiled from, so changed shaders aren't loaded
+					std::uint64_t sourceHash = 0;
+					Enum format = 0;
+					std::vector<Byte> data{};
+				};
+
+				//every program that was loaded or compiled, saved to shaderCachePath when the renderer is destroyed
+				std::map<std::pair<Enums::Brush, Enums::RenderFeatures>, ProgramBinary> programBinaries{};
+				//empty if shaders aren't cached
+				std::string shaderCachePath{};
+				bool shaderCacheChanged = false;
+
+				/**
+				Reads shaderCachePath into programBinaries. A missing, corrupt or outdated cache, or one from another driver, is ignored.
+				@opengl
+				*/
+				void loadShaderCache();
+				void saveShaderCache();
 			};
 		}//ogl
 	}//gfx
@@ -2,6 +2,23 @@ R""(
 layout(location = MACE_SCENE_ATTACHMENT_INDEX) out lowp vec4 _mc_OutColor;
 layout(location = MACE_ID_ATTACHMENT_INDEX) out uint _mc_OutID;
 
+#ifdef MACE_INSTANCED
+flat in lowp vec4 _mcInstanceColor;
+#endif
+
+#ifdef MACE_BATCHED
+flat in vec4 _mcForegroundColor;
+flat in vec4 _mcForegroundTransform;
+flat in vec4 _mcMaskColor;
+flat in vec4 _mcMaskTransform;
+flat in uint _mcEntityID;
+
+//filled in from the instance attributes at the start of main()
+_mc_TextureAttachment mc_Foreground;
+_mc_TextureAttachment mc_Background;
+_mc_TextureAttachment mc_Mask;
+#endif
+
 #ifdef MACE_TEXTURE
 in highp vec2 _mcTextureCoord;
 
@@ -31,8 +48,18 @@ vec4 mcGetMask(const in sampler2D mc_Samp){
 vec4 mc_frag_main(void);
 
 void main(void){
+#ifdef MACE_BATCHED
+	mc_Foreground = _mc_TextureAttachment(_mcForegroundColor, _mcForegroundTransform);
+	mc_Background = _mc_PainterBackground;
+	mc_Mask = _mc_TextureAttachment(_mcMaskColor, _mcMaskTransform);
+#endif
+
 	vec4 mc_Fragment = mc_frag_main();
 
+#ifdef MACE_INSTANCED
+	mc_Fragment *= _mcInstanceColor;
+#endif
+
 #ifdef MACE_DISCARD_INVISIBLE
 	if(mc_Fragment.a == 0){
 		discard;
@@ -44,6 +71,10 @@ void main(void){
 #else
 	_mc_OutColor = mc_Fragment;
 #endif	
+#ifdef MACE_BATCHED
+	_mc_OutID = _mcEntityID;
+#else
 	_mc_OutID = mc_EntityID;
+#endif
 }
 )""
@@ -3,17 +3,14 @@ R""(
 
 precision highp float; // Defines precision for float and float-derived (vector/matrix) types.
 
-struct mc_EntityDataStruct{
-	vec3 mc_Translation;
-	vec3 mc_Rotation;
-};
-
+//batched draws get their entity data from instance attributes
+#ifndef MACE_BATCHED
 MACE_UNIFORM_BUFFER MACE_ENTITY_DATA_NAME{
-	mc_EntityDataStruct mc_BaseEntity;
-	mc_EntityDataStruct mc_ParentEntity;
-	vec3 mc_Scale;
+	//transforms from the space of the entity to the window, including every parent
+	mat4 mc_EntityMatrix;
 	uint mc_EntityID;
 };
+#endif
 
 struct _mc_TextureAttachment{
 	vec4 mc_Color;
@@ -21,13 +18,22 @@ struct _mc_TextureAttachment{
 };
 
 MACE_UNIFORM_BUFFER MACE_PAINTER_DATA_NAME{
-	vec3 _mc_TransformTranslation;
-	vec3 _mc_TransformRotation;
-	vec3 _mc_TransformScale;
+#ifdef MACE_BATCHED
+	//the layout has to stay the same, but everything except mc_Data, the background, and the filter comes from instance attributes instead
+	mat4 _mc_PainterTransformMatrix;
+#else
+	mat4 _mc_TransformMatrix;
+#endif
 	vec4 mc_Data;
+#ifdef MACE_BATCHED
+	_mc_TextureAttachment _mc_PainterForeground;
+	_mc_TextureAttachment _mc_PainterBackground;
+	_mc_TextureAttachment _mc_PainterMask;
+#else
 	_mc_TextureAttachment mc_Foreground;
 	_mc_TextureAttachment mc_Background;
 	_mc_TextureAttachment mc_Mask;
+#endif
 	mat4 _mc_Filter;
 };
 )""
@@ -7,22 +7,51 @@ out highp vec2 _mcTextureCoord;
 
 layout(location = MACE_VAO_DEFAULT_VERTICES_LOCATION) in vec3 _mc_VertexPosition;
 
-mat3 _mcCreateRotationMatrix(const in vec3 mc_RotationInput){
-	float mc_CosZ = cos(mc_RotationInput.z), mc_SinZ = sin(mc_RotationInput.z),
-		   mc_CosY = cos(mc_RotationInput.y), mc_SinY = sin(mc_RotationInput.y),
-		   mc_CosX = cos(mc_RotationInput.x), mc_SinX = sin(mc_RotationInput.x);
-		   
-	return mat3(
-					mc_CosZ*mc_CosY, mc_SinZ, -mc_SinY,
-					-mc_SinZ, mc_CosZ*mc_CosX, mc_SinX,
-					mc_SinY,-mc_SinX,mc_CosX*mc_CosY
-					);
+#ifdef MACE_INSTANCED
+//xy is the offset, z is the scale, and w is the rotation
+layout(location = MACE_VAO_INSTANCE_TRANSFORM_LOCATION) in vec4 _mc_InstanceTransform;
+layout(location = MACE_VAO_INSTANCE_COLOR_LOCATION) in vec4 _mc_InstanceColor;
+
+flat out lowp vec4 _mcInstanceColor;
+#endif
+
+#ifdef MACE_BATCHED
+//the painter transformation and the world matrix of the entity, multiplied together
+layout(location = MACE_VAO_BATCH_MATRIX_LOCATION) in mat4 _mc_BatchMatrix;
+layout(location = MACE_VAO_BATCH_FOREGROUND_COLOR_LOCATION) in vec4 _mc_BatchForegroundColor;
+layout(location = MACE_VAO_BATCH_FOREGROUND_TRANSFORM_LOCATION) in vec4 _mc_BatchForegroundTransform;
+layout(location = MACE_VAO_BATCH_MASK_COLOR_LOCATION) in vec4 _mc_BatchMaskColor;
+layout(location = MACE_VAO_BATCH_MASK_TRANSFORM_LOCATION) in vec4 _mc_BatchMaskTransform;
+layout(location = MACE_VAO_BATCH_ENTITY_ID_LOCATION) in uint _mc_BatchEntityID;
+layout(location = MACE_VAO_BATCH_DEPTH_LOCATION) in float _mc_BatchDepth;
+
+flat out vec4 _mcForegroundColor;
+flat out vec4 _mcForegroundTransform;
+flat out vec4 _mcMaskColor;
+flat out vec4 _mcMaskTransform;
+flat out uint _mcEntityID;
+#else
+uniform float _mc_DrawDepth;
+#endif
+
+vec3 _mcGetVertexPosition(){
+#ifdef MACE_INSTANCED
+	float mc_Cos = cos(_mc_InstanceTransform.w), mc_Sin = sin(_mc_InstanceTransform.w);
+	vec2 mc_Scaled = _mc_VertexPosition.xy * _mc_InstanceTransform.z;
+
+	return vec3(mat2(mc_Cos, mc_Sin, -mc_Sin, mc_Cos) * mc_Scaled + _mc_InstanceTransform.xy, _mc_VertexPosition.z);
+#else
+	return _mc_VertexPosition;
+#endif
 }
 
+//every matrix is composed on the CPU, so a vertex is only multiplied, no matter how deep the entity is
 vec4 mcGetEntityPosition(){
-	//putting it all in one line allows for the compiler to optimize it into a single MAD operation		
-	return vec4((_mc_VertexPosition * _mc_TransformScale * _mcCreateRotationMatrix(_mc_TransformRotation) + _mc_TransformTranslation) * mc_Scale * _mcCreateRotationMatrix(mc_BaseEntity.mc_Rotation)
-							  + mc_BaseEntity.mc_Translation * _mcCreateRotationMatrix(mc_ParentEntity.mc_Rotation) + mc_ParentEntity.mc_Translation, 1.0);
+#ifdef MACE_BATCHED
+	return _mc_BatchMatrix * vec4(_mcGetVertexPosition(), 1.0);
+#else
+	return mc_EntityMatrix * (_mc_TransformMatrix * vec4(_mcGetVertexPosition(), 1.0));
+#endif
 }
 
 vec4 mc_vert_main(vec4);
@@ -32,6 +61,25 @@ void main(void){
 	_mcTextureCoord = _mcInputTextureCoord;
 #endif
 
+#ifdef MACE_INSTANCED
+	_mcInstanceColor = _mc_InstanceColor;
+#endif
+
+#ifdef MACE_BATCHED
+	_mcForegroundColor = _mc_BatchForegroundColor;
+	_mcForegroundTransform = _mc_BatchForegroundTransform;
+	_mcMaskColor = _mc_BatchMaskColor;
+	_mcMaskTransform = _mc_BatchMaskTransform;
+	_mcEntityID = _mc_BatchEntityID;
+#endif
+
 	gl_Position = mc_vert_main(mcGetEntityPosition());
+
+	//draws are ordered by their depth instead of their Z coordinate, so the depth test keeps the order they were recorded in
+#ifdef MACE_BATCHED
+	gl_Position.z = _mc_BatchDepth * gl_Position.w;
+#else
+	gl_Position.z = _mc_DrawDepth * gl_Position.w;
+#endif
 }
 )""
@@ -0,0 +1,216 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2016 Liav Turkia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+#pragma once
+#ifndef MACE__GRAPHICS_PARTICLES_H
+#define MACE__GRAPHICS_PARTICLES_H
+
+#include <MACE/Core/Constants.h>
+#include <MACE/Graphics/Entity2D.h>
+#include <MACE/Graphics/Components.h>
+#include <MACE/Graphics/Context.h>
+#include <MACE/Utility/Vector.h>
+#include <MACE/Utility/Color.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace mc {
+	namespace gfx {
+		/**
+		`Entity` that simulates and draws a large amount of particles.
+		<p>
+		Particles are not entities. They are stored as a structure of arrays, are simulated with SIMD instructions when
+		the compiler supports them, and are drawn with a single instanced draw call no matter how many there are.
+		<p>
+		Every particle is a quad in the coordinate space of the `ParticleEmitter`, so a particle at (0, 0) is at the center
+		of the `ParticleEmitter` and a particle at (1, 1) is at it's top right corner. Particles spawn at the center.
+		<p>
+		The simulation is stepped every time the `ParticleEmitter` is updated, using the real time since the last update.
+		ParticleEmitter::simulate(const float) can be used to step it manually.
+		@see Painter::drawInstances(const Model&, const Enums::Brush, const Enums::RenderFeatures, const InstanceData*, const Size)
+		*/
+		class ParticleEmitter: public Entity2D, public Texturable {
+		public:
+			ParticleEmitter() noexcept;
+			ParticleEmitter(const Size capacity);
+			~ParticleEmitter();
+
+			/**
+			Steps the simulation, spawning new particles and killing the ones that have expired.
+			<p>
+			If more than 1 thread is used and there are enough particles, the particles are split evenly between the threads.
+			@param delta How many seconds to advance the simulation by
+			@see ParticleEmitter::setThreadCount(const Size)
+			*/
+			void simulate(const float delta);
+
+			/**
+			Spawns particles immediately, regardless of the emission rate.
+			@param count How many particles to spawn. Particles past the capacity are ignored.
+			*/
+			void emit(const Size count);
+
+			/**
+			Kills every particle.
+			*/
+			void clear();
+
+			Size getParticleCount() const;
+
+			/**
+			Sets the maximum amount of particles that can be alive at one time. Reducing the capacity kills the newest particles.
+			*/
+			void setCapacity(const Size capacity);
+			Size getCapacity() const;
+
+			/**
+			@param rate How many particles are spawned every second
+			*/
+			void setEmissionRate(const float rate);
+			float getEmissionRate() const;
+
+			/**
+			@param minimum The shortest a particle can live, in seconds
+			@param maximum The longest a particle can live, in seconds
+			*/
+			void setLifetime(const float minimum, const float maximum);
+			Vector<float, 2> getLifetime() const;
+
+			/**
+			Each particle is given a random velocity between `minimum` and `maximum`, measured in units per second.
+			*/
+			void setVelocity(const Vector<float, 2>& minimum, const Vector<float, 2>& maximum);
+			const Vector<float, 2>& getMinimumVelocity() const;
+			const Vector<float, 2>& getMaximumVelocity() const;
+
+			/**
+			Each particle is given a random angular velocity between `minimum` and `maximum`, measured in radians per second.
+			*/
+			void setAngularVelocity(const float minimum, const float maximum);
+			Vector<float, 2> getAngularVelocity() const;
+
+			/**
+			@param accel Acceleration applied to every particle, like gravity or wind, measured in units per second squared.
+			*/
+			void setAcceleration(const Vector<float, 2>& accel);
+			const Vector<float, 2>& getAcceleration() const;
+
+			/**
+			The size of each particle is interpolated from `start` to `end` over it's lifetime
+			*/
+			void setSize(const float start, const float end);
+			Vector<float, 2> getSize() const;
+
+			/**
+			The color of each particle is interpolated from `start` to `end` over it's lifetime
+			*/
+			void setColor(const Color& start, const Color& end);
+			const Color& getStartColor() const;
+			const Color& getEndColor() const;
+
+			/**
+			@param threads The maximum amount of threads used to simulate particles. 1 by default, meaning that only the calling thread is used.
+			The extra threads are started the first time they are needed, and wait for the next step in between.
+			*/
+			void setThreadCount(const Size threads);
+			Size getThreadCount() const;
+
+			/**
+			If no `Texture` is set, every particle is a solid quad.
+			@dirty
+			*/
+			void setTexture(const Texture& tex) override;
+			/**
+			@dirty
+			*/
+			Texture& getTexture() override;
+			const Texture& getTexture() const override;
+
+			bool operator==(const ParticleEmitter& other) const;
+			bool operator!=(const ParticleEmitter& other) const;
+		protected:
+			void onInit() override;
+			void onUpdate() override;
+			void onRender(Painter& p) override;
+			void onDestroy() override;
+			void onClean() override;
+		private:
+			//structure of arrays, so each field can be simulated 4 particles at a time
+			struct {
+				std::vector<float> positionX, positionY;
+				std::vector<float> velocityX, velocityY;
+				std::vector<float> rotation, angularVelocity;
+				std::vector<float> age, lifetime;
+			} particles{};
+
+			Size particleCount = 0;
+			Size capacity = 0;
+
+			float emissionRate = 0.0f;
+			//fractional particles that werent spawned last step
+			float emissionAccumulator = 0.0f;
+
+			Vector<float, 2> lifetime = { 1.0f, 1.0f };
+			Vector<float, 2> minimumVelocity = { 0.0f, 0.0f }, maximumVelocity = { 0.0f, 0.0f };
+			Vector<float, 2> angularVelocity = { 0.0f, 0.0f };
+			Vector<float, 2> acceleration = { 0.0f, 0.0f };
+			Vector<float, 2> size = { 0.05f, 0.05f };
+
+			Color startColor = Colors::WHITE, endColor = Colors::WHITE;
+
+			Size threadCount = 1;
+
+			Texture texture;
+
+			std::mt19937 random;
+
+			std::chrono::steady_clock::time_point lastUpdate;
+
+			//written after every simulation step and read when rendering, which may happen on another thread
+			std::vector<InstanceData> instances{}, pendingInstances{};
+			std::mutex instanceMutex;
+
+			/*
+			threads are kept between steps, as starting them every step would cost more than they save. each worker takes
+			1 range of the current job, and the calling thread takes the last one
+			*/
+			std::vector<std::thread> workers{};
+			std::mutex workerMutex;
+			std::condition_variable workerStart{}, workerFinish{};
+			const std::function<void(const Index, const Index)>* workerJob = nullptr;
+			Size workerRangeSize = 0, activeWorkers = 0, busyWorkers = 0;
+			//incremented for every job, so a worker knows when there is a new one
+			Size workerGeneration = 0;
+			bool stoppingWorkers = false;
+
+			void spawn(const Size count);
+			//also moves the instance of the last particle, so it must be called after the instances were written
+			void kill(const Index particle);
+			void writeInstances();
+			void publishInstances();
+
+			/*
+			calls func with ranges of [0, count) on up to threadCount threads, and returns once every range is done.
+			every range except the last one is a multiple of 4
+			*/
+			void forEachRange(const Size count, const std::function<void(const Index, const Index)>& func);
+			//generation is the last job the worker shouldn't take part in
+			void runWorker(const Index worker, Size generation);
+			void stopWorkers();
+		};//ParticleEmitter
+	}//gfx
+}//mc
+
+#endif
@@ -15,12 +15,15 @@ The above copyright notice and this permission notice shall be included in all c
 #include <MACE/Core/Error.h>
 #include <MACE/Graphics/Entity.h>
 #include <MACE/Graphics/Window.h>
+#include <MACE/Graphics/Context.h>
 #include <MACE/Utility/Vector.h>
 #include <MACE/Utility/Transform.h>
 #include <MACE/Utility/Color.h>
 
+#include <chrono>
 #include <deque>
-#include <stack>
+#include <vector>
+#include <mutex>
 
 namespace mc {
 	namespace gfx {
@@ -47,6 +50,21 @@ namespace mc {
 				FILTER = 0x02,
 				TEXTURE = 0x04,
 				TEXTURE_TRANSFORM = 0x08,
+				INSTANCED = 0x10,
+				/**
+				Set by the `Renderer` on draws that it combined into a batch. Should not be used directly.
+				@internal
+				*/
+				BATCHED = 0x20,
+				/**
+				Promises that every pixel of the draw is fully opaque. Opaque draws are drawn before everything else, front
+				to back and with depth writes, so anything they cover is rejected before it's shaded. `DISCARD_INVISIBLE`
+				is ignored for them.
+				<p>
+				The `Renderer` already treats solid `Enums::Brush::COLOR` draws as opaque. Textured draws have to set this,
+				as the `Renderer` can't know whether their textures have transparent pixels.
+				*/
+				FULLY_OPAQUE = 0x40,
 
 				NONE = 0x00,
 				DEFAULT = FILTER | TEXTURE | TEXTURE_TRANSFORM,
@@ -74,6 +92,19 @@ namespace mc {
 			};
 		}
 
+		/**
+		Per-instance data used by Painter::drawInstances(). Every instance is the `Model` scaled by `scale`, rotated on the
+		z-axis by `rotation` radians, and then moved by `x` and `y`, before the `Painter` and `Entity` transformations are applied.
+		<p>
+		The final color of each instance is multiplied by `color`
+		*/
+		struct InstanceData {
+			float x, y, scale, rotation;
+			float r, g, b, a;
+		};
+
+		MACE_STATIC_ASSERT(sizeof(InstanceData) == sizeof(float) * 8, "InstanceData must be tightly packed to be uploaded to the GPU");
+
 		class Painter: public Beginable, private Initializable {
 			friend class GraphicsEntity;
 			friend class PainterImpl;
@@ -93,6 +124,27 @@ namespace mc {
 				bool operator!=(const State& other) const;
 			};
 
+			/**
+			A bit for each field of a `State`, to track which fields changed without comparing them
+			*/
+			enum StateField: unsigned int {
+				FOREGROUND_COLOR = 0x001,
+				BACKGROUND_COLOR = 0x002,
+				MASK_COLOR = 0x004,
+				FOREGROUND_TRANSFORM = 0x008,
+				BACKGROUND_TRANSFORM = 0x010,
+				MASK_TRANSFORM = 0x020,
+				DATA = 0x040,
+				TRANSFORMATION = 0x080,
+				FILTER = 0x100,
+				ALL_FIELDS = 0x1FF
+			};
+
+			/**
+			Bitmask of `StateField`
+			*/
+			using StateFields = unsigned int;
+
 			Painter() = delete;
 			Painter(const Painter& p);
 			~Painter() = default;
@@ -115,6 +167,20 @@ namespace mc {
 			void drawQuad(const Enums::Brush brush, const Enums::RenderFeatures features = Enums::RenderFeatures::DEFAULT);
 			void draw(const Model& m, const Enums::Brush brush, const Enums::RenderFeatures features);
 
+			/**
+			Draws a `Model` once for every element in `instances` with a single draw call.
+			<p>
+			Enums::RenderFeatures::INSTANCED is added to `features` automatically.
+			@param m The `Model` to draw
+			@param brush Which `Brush` to use for every instance
+			@param features What features to use for every instance
+			@param instances Pointer to the `InstanceData` for each instance
+			@param count How many elements are in `instances`
+			@see InstanceData
+			@opengl
+			*/
+			void drawInstances(const Model& m, const Enums::Brush brush, const Enums::RenderFeatures features, const InstanceData* instances, const Size count);
+
 			const GraphicsEntity* const getEntity() const;
 
 			void setTexture(const Texture& t, const Enums::TextureSlot& slot);
@@ -182,8 +248,22 @@ namespace mc {
 			State& getState();
 			const State& getState() const;
 
+			/**
+			Retrieves a counter that is incremented every time the state changes. Functions that return a non-const reference
+			to the state count as changing it, as it could be changed through the reference.
+			*/
+			Size getStateVersion() const;
+
 			const EntityID& getID() const;
 
+			/**
+			Replaces what draws for this `Painter`, and the ID it draws with. Initializing the entity replaces both with ones
+			from the `Renderer` of the current window, so this is only useful for entities that are never initialized
+			normally, like in tests.
+			@internal
+			*/
+			void setImpl(const std::shared_ptr<PainterImpl>& implementation, const EntityID entityID);
+
 			Painter operator=(const Painter& right);
 
 			bool operator==(const Painter& other) const;
@@ -193,13 +273,61 @@ namespace mc {
 
 			Painter::State state = Painter::State();
 
-			//for pushing/popping the state
-			std::stack<Painter::State> stateStack{};
+			Size stateVersion = 0;
+			//fields changed since the last draw, which are given to the implementation with the state
+			StateFields changedFields = ALL_FIELDS;
+
+			/*
+			push() doesn't copy the state. the first time a field changes after a push, it's old value is saved to the pool
+			of it's type, and pop() only restores the fields that were saved. pushedFields has the fields saved by each push
+			*/
+			std::vector<StateFields> pushedFields{};
+			//which field every saved value belongs to, in the order they were saved
+			std::vector<StateField> savedFields{};
+			std::vector<Color> savedColors{};
+			std::vector<Vector<float, 4>> savedVectors{};
+			std::vector<TransformMatrix> savedTransformations{};
+			std::vector<Matrix<float, 4, 4>> savedFilters{};
 
 			GraphicsEntity* const entity = nullptr;
 
 			EntityID id = 0;
 
+			/*
+			the draws of the last call to GraphicsEntity::onRender(Painter&), which are replayed instead of calling it
+			again while the entity doesn't change. textures are only recorded when they are set, and consecutive draws with
+			the same state share it
+			*/
+			struct RecordedDraw {
+				Model model;
+				Enums::Brush brush;
+				Enums::RenderFeatures features;
+				Index state;
+				//only used if the draw is instanced
+				Index instanceOffset;
+				Size instanceCount;
+			};
+
+			struct RecordedTexture {
+				Texture texture;
+				Enums::TextureSlot slot;
+				//the draw it was set before
+				Index draw;
+			};
+
+			std::vector<RecordedDraw> recordedDraws{};
+			std::vector<RecordedTexture> recordedTextures{};
+			std::vector<Painter::State> recordedStates{};
+			//the fields of each recorded state that changed since the one before it
+			std::vector<StateFields> recordedChanges{};
+			std::vector<InstanceData> recordedInstances{};
+			//what the state was after recording, so replaying leaves the painter the same way
+			Painter::State recordedEndState = Painter::State();
+			//draws depend on where the entity is, like when they are culled. this changes when any parent moves as well
+			Matrix<float, 4> recordedWorldMatrix = math::identity<float, 4>();
+			Size recordedRevision = 0;
+			bool recording = false, recorded = false;
+
 			Painter(GraphicsEntity* const en);
 
 			void begin() override;
@@ -209,6 +337,23 @@ namespace mc {
 			void destroy() override;
 
 			void clean();
+
+			/**
+			Starts recording every draw until Painter::endRecording(), replacing the last recording
+			*/
+			void beginRecording();
+			void endRecording();
+			/**
+			Replays the last recording, if the entity hasn't been made dirty and it's world matrix hasn't changed since.
+			@return Whether it was replayed. If not, GraphicsEntity::onRender(Painter&) has to be called.
+			*/
+			bool replay();
+			void record(const Model& m, const Enums::Brush brush, const Enums::RenderFeatures feat, const InstanceData* instances, const Size count);
+
+			/**
+			Must be called before `fields` are changed. Saves them if they weren't saved since the last push(), and marks them as changed.
+			*/
+			void change(const StateFields fields);
 		};
 
 		class PainterImpl: public Initializable, public Beginable {
@@ -225,8 +370,19 @@ namespace mc {
 
 			virtual void clean() = 0;
 
-			virtual void loadSettings(const Painter::State& state) = 0;
+			/**
+			Called before every draw with the state to draw it with.
+			@param changed Which fields of `state` changed since the last state given to this function. If it is 0, `state`
+			is the same as last time.
+			*/
+			virtual void loadSettings(const Painter::State& state, const Painter::StateFields changed) = 0;
+			/**
+			Called by Painter::setTexture(const Texture&, const Enums::TextureSlot&). The implementation decides when
+			the `Texture` is actually bound, which may be later than this call.
+			*/
+			virtual void bindTexture(const Texture& t, const Enums::TextureSlot slot) = 0;
 			virtual void draw(const Model& m, const Enums::Brush brush, const Enums::RenderFeatures features) = 0;
+			virtual void drawInstanced(const Model& m, const Enums::Brush brush, const Enums::RenderFeatures features, const InstanceData* instances, const Size count) = 0;
 
 			bool operator==(const PainterImpl& other) const;
 			bool operator!=(const PainterImpl& other) const;
@@ -236,11 +392,141 @@ namespace mc {
 			Painter* const painter;
 		};
 
+		/**
+		Routes input events to the entities and components that subscribed to them, using the `Entity` found by
+		Renderer::getEntityAt(const int, const int) as the target.
+		<p>
+		Mouse buttons and scrolling are queued from the input callbacks via EventRouter::queueEvent(const Event&) and are
+		dispatched on the rendering thread, along with `Event::HOVER_ENTER`, `Event::HOVER_LEAVE` and `Event::HOVER`
+		which are generated from the hit test every frame.
+		@see Event
+		@see Entity::subscribe(const EventMask, const bool)
+		*/
+		class EventRouter {
+			friend class Renderer;
+		public:
+			/**
+			Queues an `Event` to be dispatched to the hovered `Entity` the next time input is checked.
+			<p>
+			This function is thread safe.
+			@param e The `Event` to queue. Event::target and Event::phase are set when it is dispatched.
+			*/
+			void queueEvent(const Event& e);
+
+			/**
+			Dispatches an `Event` to Event::target and every one of it's parents, in the capture, target, and bubble phases.
+			Only the entities that subscribed to the event are given it.
+			@param e The `Event` to dispatch. Event::target must not be `nullptr`
+			@opengl
+			*/
+			static void dispatch(Event& e);
+
+			/**
+			Retrieves the ID of the `GraphicsEntity` the mouse was over the last time input was checked, or 0 if there was none.
+			*/
+			EntityID getHoveredID() const;
+		private:
+			std::vector<Event> pendingEvents{};
+			std::mutex pendingMutex;
+
+			//the ID of a removed entity can be given to a new one, so the entity is kept instead of looking it up again
+			GraphicsEntity* hovered = nullptr;
+			EntityID hoveredID = 0;
+		};//EventRouter
+
+		/**
+		Counters describing the work done to render a frame.
+		@see Renderer::getStatistics()
+		*/
+		struct RenderStatistics {
+			/**
+			How many draw calls were sent to the GPU
+			*/
+			Size drawCalls = 0;
+			/**
+			How many of the draw calls were batches of multiple draws
+			*/
+			Size batches = 0;
+			/**
+			How many Painter draws were combined into batches instead of being drawn on their own
+			*/
+			Size batchedDraws = 0;
+			/**
+			How many times a different shader had to be bound
+			*/
+			Size programBinds = 0;
+			/**
+			How many times a different texture had to be bound
+			*/
+			Size textureBinds = 0;
+			/**
+			How many binds and state changes were sent to the graphics API
+			*/
+			Size stateChanges = 0;
+			/**
+			How many binds and state changes were skipped because they wouldn't have changed anything
+			*/
+			Size skippedStateChanges = 0;
+			/**
+			Milliseconds from the start of the frame until it was presented, measured on the CPU
+			*/
+			float frameTime = 0.0f;
+			/**
+			Milliseconds the CPU spent recording and submitting the frame, which is `frameTime` without `presentTime`
+			*/
+			float cpuTime = 0.0f;
+			/**
+			Milliseconds spent presenting the frame. With vsync this includes waiting for the display.
+			*/
+			float presentTime = 0.0f;
+			/**
+			Milliseconds the GPU spent rendering a frame. GPU timings arrive a few frames late, so this is from an earlier
+			frame than the rest. 0 if it isn't supported or no result has arrived yet.
+			*/
+			float gpuTime = 0.0f;
+			/**
+			Milliseconds between this frame and the previous frame being presented, which is the actual frame rate
+			*/
+			float frameInterval = 0.0f;
+			/**
+			Whether the frame was rendered offscreen with an entity ID attachment for picking. If nothing is subscribed
+			to any event, the frame is rendered straight to the window instead.
+			@see SubscriberCounter::hasSubscribers()
+			*/
+			bool picking = false;
+			/**
+			The resolution the frame was rendered at, as a fraction of the window size. Lower than 1 if frames didn't
+			fit in the GPU budget.
+			@see WindowModule::LaunchConfig::gpuBudget
+			*/
+			float renderScale = 1.0f;
+			/**
+			How many cached subtrees were drawn from their cache
+			@see Entity::setCached(const bool)
+			*/
+			Size cacheHits = 0;
+			/**
+			How many cached subtrees had to be rendered into their cache again
+			*/
+			Size cacheMisses = 0;
+			/**
+			How many subtrees were recorded on another thread
+			@see Entity::setParallel(const bool)
+			*/
+			Size parallelRecordings = 0;
+			/**
+			How many draws were drawn in the opaque pass, where they hide what is behind them from the GPU
+			@see Enums::RenderFeatures::FULLY_OPAQUE
+			*/
+			Size opaqueDraws = 0;
+		};
+
 		/**
 		@todo add function to change how many samples msaa uses
 		@todo add renderers for directx, cpu, vulkan, opengl es, opengl 1.1/2.1
 		*/
 		class Renderer {
+			friend class Entity;
 			friend class Painter;
 			friend class GraphicsContext;
 			friend class WindowModule;
@@ -273,6 +559,28 @@ namespace mc {
 			GraphicsContext* getContext();
 			const GraphicsContext* getContext() const;
 
+			EventRouter& getEventRouter();
+			const EventRouter& getEventRouter() const;
+
+			/**
+			Retrieves the counters of the last frame that was fully rendered.
+			*/
+			const RenderStatistics& getStatistics() const;
+
+			/**
+			Whether the last frame was rendered with entity IDs, which Renderer::getEntityAt(const int, const int) needs.
+			<p>
+			They are only rendered while an `Entity` or `Component` is subscribed to an event.
+			*/
+			bool isPickingEnabled() const;
+
+			/**
+			Whether the `Renderer` is waiting for results from the GPU that input checking depends on. An idle window
+			keeps checking input until there are none.
+			@see WindowModule::LaunchConfig::idle
+			*/
+			virtual bool hasPendingResults() const;
+
 			/**
 			@internal
 			*/
@@ -288,13 +596,91 @@ namespace mc {
 
 			GraphicsContext* context;
 
+			EventRouter eventRouter{};
+
+			/**
+			Counters of the frame being rendered. Implementations increment these and measure `presentTime` and `gpuTime`,
+			and they are published to Renderer::getStatistics() when the frame ends.
+			*/
+			RenderStatistics frameStatistics{};
+
+			/**
+			Whether the frame being rendered needs entity IDs.
+			@see Renderer::isPickingEnabled()
+			*/
+			bool picking = false;
+
+			/**
+			How many frames were set up so far, including the one being rendered.
+			*/
+			Size frameCount = 0;
+
+			/**
+			Frees the ID of a `GraphicsEntity` for another one, and makes sure no events are sent to the removed one.
+			<p>
+			The ID is given to the next entity that is queued, so IDs that were read back from frames rendered before that
+			have to be checked with Renderer::getPickedEntity(const EntityID, const Size) const.
+			@param id The ID to free
+			*/
+			void remove(const EntityID id);
+
+			/**
+			Retrieves the `GraphicsEntity` that a picked ID belonged to. An ID read from a frame that was rendered before the
+			entity that has it now was queued belongs to a removed one.
+			@param id The ID that was read back
+			@param frame What Renderer::frameCount was when the frame it was read from was rendered
+			@return The entity, or `nullptr` if it was removed
+			*/
+			GraphicsEntity* getPickedEntity(const EntityID id, const Size frame) const;
+
 			virtual void onResize(gfx::WindowModule* win, const Size width, const Size height) = 0;
 			virtual void onInit(gfx::WindowModule* win) = 0;
 			virtual void onSetUp(gfx::WindowModule* win) = 0;
+			/**
+			Submits and presents the frame recorded since onSetUp(gfx::WindowModule*).
+			<p>
+			This is called without the entities being locked, while the next frame may be updated on another thread, so it
+			must only use what was copied into the `Renderer` while recording, and never an `Entity` or `Painter`.
+			*/
 			virtual void onTearDown(gfx::WindowModule* win) = 0;
 			virtual void onDestroy() = 0;
 			virtual void onQueue(GraphicsEntity* en) = 0;
 
+			/**
+			Called before a cached `Entity` renders it's subtree. The default implementation doesn't cache anything.
+			@param en The cached `Entity`
+			@param id Identifies the cache of `en`
+			@param stale Whether anything in the subtree was made dirty since it was last rendered
+			@return Whether the subtree has to be rendered. If `false`, the cache was drawn instead.
+			@see Entity::setCached(const bool)
+			*/
+			virtual bool onBeginCache(Entity* en, const Index id, const bool stale);
+			/**
+			Called after a cached `Entity` rendered it's subtree, or after the cache was drawn instead.
+			*/
+			virtual void onEndCache(Entity* en, const Index id);
+
+			/**
+			Called to record the draws of a subtree that was already initialized and cleaned. Implementations that can record
+			on other threads may record it on one, as long as it's draws are kept in the same order and it is done by
+			onFinishRecording(). The default implementation records it on the calling thread.
+			@see Entity::setParallel(const bool)
+			@see Renderer::record(Entity*)
+			*/
+			virtual void onRecordParallel(Entity* en);
+			/**
+			Called after the whole tree was rendered, while the entities are still locked. Every subtree being recorded on
+			another thread has to be done before this returns.
+			*/
+			virtual void onFinishRecording();
+
+			/**
+			Calls Entity::onRender() on `en` and it's children, without initializing, cleaning or caching them, or calling
+			Component::render(). Doesn't call OpenGL unless one of them does.
+			@see Entity::prepare()
+			*/
+			static void record(Entity* en);
+
 			//not declared const because some of the functions require modification to an intneral buffer of impls
 			virtual std::shared_ptr<PainterImpl> createPainterImpl(Painter* const  painter) = 0;
 		private:
@@ -328,6 +714,29 @@ namespace mc {
 			*/
 			void checkInput(gfx::WindowModule* win);
 
+			/**
+			@internal
+			@opengl
+			*/
+			bool beginCache(Entity* en, const Index id, const bool stale);
+
+			/**
+			@internal
+			@opengl
+			*/
+			void endCache(Entity* en, const Index id);
+
+			/**
+			@internal
+			@opengl
+			*/
+			void recordParallel(Entity* en);
+
+			/**
+			@internal
+			@opengl
+			*/
+			void finishRecording();
 
 			/**
 			@internal
@@ -335,11 +744,16 @@ namespace mc {
 			*/
 			void destroy();
 
-			EntityID queue(GraphicsEntity* const e);
+			std::chrono::steady_clock::time_point frameStart{}, lastPresent{};
 
-			void remove(const EntityID i);
+			EntityID queue(GraphicsEntity* const e);
 
 			EntityID pushEntity(GraphicsEntity* const  entity);
+
+			//the value of frameCount when each ID was last given to an entity
+			std::deque<Size> queuedFrames{};
+
+			RenderStatistics statistics{};
 		};//Renderer
 
 		class GraphicsEntity: public Entity {
@@ -0,0 +1,246 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2016 Liav Turkia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+#pragma once
+#ifndef MACE__GRAPHICS_SCENE_H
+#define MACE__GRAPHICS_SCENE_H
+
+#include <MACE/Core/Constants.h>
+#include <MACE/Graphics/Entity.h>
+#include <MACE/Graphics/Entity2D.h>
+#include <MACE/Graphics/Components.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace mc {
+	namespace gfx {
+		namespace Enums {
+			enum class SceneEntityType: Byte {
+				GROUP = 0,
+				IMAGE = 1,
+				PROGRESS_BAR = 2,
+				TEXT = 3,
+				BUTTON = 4,
+			};
+
+			enum class SceneComponentType: Byte {
+				ALIGNMENT = 0,
+			};
+		}
+
+		/**
+		Layout of a binary scene file, as written by `SceneWriter` and read by `Scene`.
+		<p>
+		A scene file starts with a `SceneFormat::Header`, followed by an array of `SceneFormat::EntityRecord`, an array of
+		`SceneFormat::ComponentRecord`, and a string table. All records have a fixed size and are 4 byte aligned, so they are
+		used straight from the mapped file without any parsing.
+		<p>
+		Entities are stored in pre-order, meaning that a parent always comes before it's children.
+		<p>
+		Strings are referenced by their byte offset in the string table. Each string is stored as a `std::uint32_t` length
+		followed by it's characters, padded to 4 bytes. Text is stored as UTF-32 code points, everything else as UTF-8.
+		<p>
+		All values are little-endian.
+		*/
+		namespace SceneFormat {
+			MACE_CONSTEXPR const std::uint32_t VERSION = 1;
+
+			/**
+			String offset meaning that there is no string
+			*/
+			MACE_CONSTEXPR const std::uint32_t NO_STRING = 0xFFFFFFFF;
+
+			MACE_CONSTEXPR const Size ENTITY_TYPES = 5;
+
+			/**
+			Maximum amount of textures used by any entity type
+			*/
+			MACE_CONSTEXPR const Size TEXTURE_SLOTS = 4;
+
+			struct Header {
+				char magic[4];
+				std::uint32_t version;
+
+				std::uint32_t entityCount;
+				std::uint32_t componentCount;
+
+				/**
+				Amount of entities of every `Enums::SceneEntityType`, so storage can be reserved before they are created
+				*/
+				std::uint32_t typeCounts[ENTITY_TYPES];
+
+				std::uint32_t entityOffset;
+				std::uint32_t componentOffset;
+				std::uint32_t stringOffset;
+				std::uint32_t stringSize;
+			};//Header
+
+			/**
+			A texture is referenced by name. When loading, the name is looked up in the `GraphicsContext`. If it isn't found,
+			it is loaded from the file of the same name and added to the `GraphicsContext`
+			@see GraphicsContext::createTexture(const std::string&, const Texture&)
+			*/
+			struct TextureReference {
+				std::uint32_t name;
+				float hue[4];
+				float transform[4];
+			};//TextureReference
+
+			struct EntityRecord {
+				/**
+				Index of the parent record plus 1, or 0 if the parent is the root of the `Scene`
+				*/
+				std::uint32_t parent;
+
+				std::uint8_t type;
+				std::uint8_t properties;
+				std::uint16_t componentCount;
+				std::uint32_t firstComponent;
+
+				float translation[3];
+				float rotation[3];
+				float scale[3];
+
+				/**
+				Image: texture
+				<br>ProgressBar: background, foreground, selection
+				<br>Text: texture
+				<br>Button: texture, hover, clicked, disabled
+				*/
+				TextureReference textures[TEXTURE_SLOTS];
+
+				/**
+				Text only. Fonts are referenced by file name, or `MC/Fonts/CODE`, `MC/Fonts/SANS`, and `MC/Fonts/SERIF` for the built-in fonts.
+				*/
+				std::uint32_t text, font, fontSize;
+				std::uint8_t verticalAlign, horizontalAlign, padding[2];
+
+				/**
+				ProgressBar only. Minimum, maximum, and progress
+				*/
+				float progress[3];
+			};//EntityRecord
+
+			struct ComponentRecord {
+				std::uint8_t type;
+				std::uint8_t data[3];
+			};//ComponentRecord
+
+			MACE_STATIC_ASSERT(sizeof(Header) == 52, "SceneFormat::Header must not have padding");
+			MACE_STATIC_ASSERT(sizeof(TextureReference) == 36, "SceneFormat::TextureReference must not have padding");
+			MACE_STATIC_ASSERT(sizeof(EntityRecord) == 220, "SceneFormat::EntityRecord must not have padding");
+			MACE_STATIC_ASSERT(sizeof(ComponentRecord) == 4, "SceneFormat::ComponentRecord must not have padding");
+		}//SceneFormat
+
+		/**
+		Entity hierarchy loaded from a binary scene file.
+		<p>
+		The file is memory mapped and every entity is created in one pass over it's records. Entities of the same type are
+		stored contiguously, so loading does not allocate once per entity.
+		<p>
+		The `Scene` owns every `Entity` it loaded, so it must outlive them. Add Scene::getRoot() to a window to display it.
+		{@code
+			scene.load("menu.mcs");
+			window.addChild(scene.getRoot());
+		}
+		@see SceneWriter
+		@see SceneFormat
+		*/
+		class Scene {
+		public:
+			Scene() = default;
+			~Scene() = default;
+
+			//entities hold pointers to each other, so they can't be copied
+			Scene(const Scene& other) = delete;
+			Scene& operator=(const Scene& other) = delete;
+
+			/**
+			Loads a scene file, replacing anything previously loaded.
+			@throws FileNotFoundError If `path` does not exist
+			@throws BadFileError If `path` is not a valid scene file
+			@opengl
+			@dirty
+			*/
+			void load(const std::string& path);
+			/**
+			@copydoc Scene::load(const std::string&)
+			*/
+			void load(const char* path);
+
+			/**
+			Removes every loaded `Entity`.
+			@dirty
+			*/
+			void clear();
+
+			Group& getRoot();
+			const Group& getRoot() const;
+
+			/**
+			Retrieves the amount of entities that were loaded, not including the root
+			*/
+			Size size() const;
+		private:
+			Group root;
+
+			std::vector<Group> groups;
+			std::vector<Image> images;
+			std::vector<ProgressBar> progressBars;
+			std::vector<Text> texts;
+			std::vector<Button> buttons;
+
+			std::vector<AlignmentComponent> alignments;
+		};//Scene
+
+		/**
+		Writes an `Entity` hierarchy to a binary scene file that can be loaded with `Scene`.
+		<p>
+		Transformations, properties, texture and font references, and `AlignmentComponent` parameters are saved. Entities of
+		a type not listed in `Enums::SceneEntityType` are saved as a `Group`, and other components are skipped.
+		<p>
+		Every `Texture` used must have been registered with GraphicsContext::createTexture(const std::string&, const Texture&)
+		so it can be referenced by name. Fonts other than the built-in fonts need to be named with SceneWriter::setFontName(const Font&, const std::string&)
+		@see Scene
+		*/
+		class SceneWriter {
+		public:
+			/**
+			Sets the name of a `Font` when it is saved. The `Scene` will load the font from a file with this name.
+			*/
+			void setFontName(const Font& f, const std::string& name);
+
+			/**
+			Writes the children of `root` to a file. `root` itself is not saved, as it is replaced by Scene::getRoot()
+			@throws ObjectNotFoundError If a `Texture` or `Font` can not be referenced by name
+			@throws BadFileError If the file could not be written
+			*/
+			void write(const Entity& root, const std::string& path);
+		private:
+			std::map<Index, std::string> fontNames{};
+
+			std::vector<SceneFormat::EntityRecord> entities{};
+			std::vector<SceneFormat::ComponentRecord> components{};
+			std::vector<Byte> strings{};
+			std::map<std::string, std::uint32_t> stringOffsets{};
+
+			std::uint32_t typeCounts[SceneFormat::ENTITY_TYPES];
+
+			void writeEntity(const Entity& e, const std::uint32_t parent);
+			SceneFormat::TextureReference writeTexture(const Texture& tex);
+			std::uint32_t writeString(const std::string& s);
+			std::uint32_t writeText(const std::wstring& s);
+		};//SceneWriter
+	}//gfx
+}//mc
+
+#endif//MACE__GRAPHICS_SCENE_H
@@ -0,0 +1,140 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2016 Liav Turkia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+#pragma once
+#ifndef MACE__GRAPHICS_TILEMAP_H
+#define MACE__GRAPHICS_TILEMAP_H
+
+#include <MACE/Core/Constants.h>
+#include <MACE/Graphics/Entity2D.h>
+#include <MACE/Graphics/Components.h>
+#include <MACE/Graphics/Context.h>
+
+#include <mutex>
+#include <vector>
+
+namespace mc {
+	namespace gfx {
+		using TileID = unsigned int;
+
+		/**
+		`Entity` that draws a grid of tiles from a texture atlas.
+		<p>
+		Tiles are not entities. The map is split into square chunks, and every chunk bakes the tiles of all of it's layers
+		into a single `Model`. A chunk is only rebuilt when one of it's tiles changes, and only the chunks that are on the
+		screen are drawn, with 1 draw call each. A static map costs almost nothing to render.
+		<p>
+		The whole map is stretched over the `TileMap`, so each tile is `getWidth() / getColumns()` wide. Layers are drawn in
+		order, so layer 1 is drawn on top of layer 0.
+		<p>
+		Tiles are numbered from 1, going left to right and then top to bottom in the atlas. TileMap::EMPTY means that
+		there is no tile.
+		*/
+		class TileMap: public Entity2D, public Texturable {
+		public:
+			static MACE_CONSTEXPR const TileID EMPTY = 0;
+
+			TileMap() noexcept;
+			/**
+			@param columns How many tiles wide the map is
+			@param rows How many tiles tall the map is
+			@param layers How many layers of tiles there are
+			@param chunkSize How many tiles wide and tall each chunk is
+			*/
+			TileMap(const Size columns, const Size rows, const Size layers = 1, const Size chunkSize = 16);
+			~TileMap() = default;
+
+			/**
+			Changes the size of the map. Every tile is set to TileMap::EMPTY
+			@dirty
+			*/
+			void resize(const Size columns, const Size rows, const Size layers = 1);
+
+			/**
+			@param columns How many tiles wide the atlas is
+			@param rows How many tiles tall the atlas is
+			@dirty
+			*/
+			void setAtlasSize(const Size columns, const Size rows);
+			Size getAtlasColumns() const;
+			Size getAtlasRows() const;
+
+			/**
+			Only the chunk containing the tile is rebuilt.
+			@dirty
+			*/
+			void setTile(const Index x, const Index y, const TileID tile, const Index layer = 0);
+			TileID getTile(const Index x, const Index y, const Index layer = 0) const;
+
+			/**
+			@dirty
+			*/
+			void fill(const TileID tile, const Index layer = 0);
+
+			Size getColumns() const;
+			Size getRows() const;
+			Size getLayerCount() const;
+			Size getChunkSize() const;
+			Size getChunkCount() const;
+
+			/**
+			Retrieves how many chunks were drawn the last time this `TileMap` was rendered.
+			*/
+			Size getDrawnChunkCount() const;
+
+			/**
+			@dirty
+			*/
+			void setTexture(const Texture& tex) override;
+			/**
+			@dirty
+			*/
+			Texture& getTexture() override;
+			const Texture& getTexture() const override;
+
+			bool operator==(const TileMap& other) const;
+			bool operator!=(const TileMap& other) const;
+		protected:
+			void onInit() override;
+			void onUpdate() override;
+			void onRender(Painter& p) override;
+			void onDestroy() override;
+			void onClean() override;
+		private:
+			struct Chunk {
+				Model model;
+				Size indexCount = 0;
+				bool dirty = true;
+			};
+
+			Size columns = 0, rows = 0, layers = 0;
+			Size chunkSize = 16;
+			Size chunkColumns = 0, chunkRows = 0;
+
+			Size atlasColumns = 1, atlasRows = 1;
+
+			//laid out as [layer][row][column]
+			std::vector<TileID> tiles{};
+			std::vector<Chunk> chunks{};
+
+			Size drawnChunks = 0;
+
+			Texture texture;
+
+			//tiles are changed on the update thread but chunks are built on the render thread
+			mutable std::mutex tileMutex;
+
+			Index getTileIndex(const Index x, const Index y, const Index layer) const;
+			void buildChunk(const Index chunk);
+			void destroyChunks();
+		};//TileMap
+	}//gfx
+}//mc
+
+#endif
@@ -15,6 +15,8 @@ The above copyright notice and this permission notice shall be included in all c
 #include <MACE/Core/Constants.h>
 #include <MACE/Graphics/Entity.h>
 
+#include <condition_variable>
+#include <mutex>
 #include <thread>
 #include <string>
 
@@ -99,8 +101,43 @@ namespace mc {
 				bool decorated = true;
 				bool fullscreen = false;
 				bool resizable = false;
+				/**
+				Presents frames in sync with the display. If `fps` is lower than the refresh rate, frames are presented every
+				n-th refresh instead, where n is the refresh rate divided by `fps`, rounded.
+				*/
 				bool vsync = false;
 
+				/**
+				Path of a file where the `Renderer` saves it's compiled shaders. When it exists, later launches on the
+				same driver load the shaders from it instead of compiling them. If `nullptr`, shaders are compiled every launch.
+				*/
+				const char* shaderCache = nullptr;
+
+				/**
+				If true, the rendering thread sleeps until the window is made dirty or receives input, instead of waking up
+				`fps` times a second. A window that isn't changing then uses no CPU time. `Event::HOVER` is only sent when
+				the mouse moves.
+				*/
+				bool idle = false;
+
+				/**
+				Milliseconds the GPU may spend on a frame. If frames keep taking longer, they are rendered at a lower
+				resolution and upscaled, and the resolution goes back up once there is room again. 0 disables it.
+				@see RenderStatistics::renderScale
+				*/
+				float gpuBudget = 0.0f;
+				/**
+				The lowest resolution frames are rendered at if they don't fit in `gpuBudget`, as a fraction of the window size
+				*/
+				float minimumRenderScale = 0.5f;
+
+				/**
+				Bytes of GPU memory that cached entities may use. When a new cache doesn't fit, the caches that were used
+				least recently are deleted.
+				@see Entity::setCached(const bool)
+				*/
+				Size renderCacheBudget = 64 * 1024 * 1024;
+
 				bool operator==(const LaunchConfig& other) const;
 				bool operator!=(const LaunchConfig& other) const;
 			};
@@ -135,6 +172,16 @@ namespace mc {
 
 			GraphicsContext* getContext();
 			const GraphicsContext* getContext() const;
+
+			/**
+			Wakes the rendering thread if it is idle, so input is checked even though nothing was made dirty.
+			<p>
+			This function is thread safe.
+			@see LaunchConfig::idle
+			*/
+			void wake();
+		protected:
+			void onDirty() override;
 		private:
 			enum Properties: Byte {
 				DESTROYED = 0,
@@ -142,12 +189,26 @@ namespace mc {
 
 			std::thread windowThread;
 
+			/*
+			guards the entity tree. the rendering thread only holds it while the frame is recorded, and submits the
+			recorded frame without it, so updating the next frame overlaps with the GPU work of the last one
+			*/
+			std::mutex entityMutex;
+
+			//signalled when an idle rendering thread should wake up
+			std::mutex wakeMutex;
+			std::condition_variable wakeSignal;
+			bool wakeRequested = false;
+
 			GLFWwindow* window;
 
 			const LaunchConfig config;
 
 			Byte properties;
 
+			//refreshes between every frame, or 0 without vsync
+			int swapInterval = 0;
+
 			std::unique_ptr<gfx::GraphicsContext> context;
 
 			void create();
@@ -178,6 +239,14 @@ namespace mc {
 		*/
 		WindowModule* getCurrentWindow();
 
+		/**
+		Makes gfx::getCurrentWindow() return `win` on this thread, even though it has no `Renderer` context. Used by
+		threads that record draws for a window without ever calling OpenGL.
+		@param win The window being recorded for, or `nullptr` once the thread is done
+		@internal
+		*/
+		void setRecordingWindow(WindowModule* win);
+
 #ifdef MACE_EXPOSE_GLFW
 		/**
 		Grabs the `WindowModule` that owns a `GLFWwindow` if it exists.
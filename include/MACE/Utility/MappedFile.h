@@ -0,0 +1,70 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2016 Liav Turkia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+#pragma once
+#ifndef MACE__UTILITY_MAPPED_FILE_H
+#define MACE__UTILITY_MAPPED_FILE_H
+
+#include <MACE/Core/Constants.h>
+
+#include <string>
+
+namespace mc {
+	namespace os {
+		/**
+		Maps a file into memory as read-only, allowing it's contents to be accessed directly without copying it into a buffer.
+		<p>
+		The operating system pages the file in as it is accessed, so large files can be opened without reading them completely.
+		<p>
+		The mapping is released when the `MappedFile` is destroyed or MappedFile::destroy() is called. Pointers returned by
+		MappedFile::getData() are invalid afterwards.
+		*/
+		class MappedFile {
+		public:
+			MappedFile();
+			MappedFile(const std::string& path);
+			MappedFile(const char* path);
+			~MappedFile();
+
+			//a mapping can't be shared between 2 objects
+			MappedFile(const MappedFile& other) = delete;
+			MappedFile& operator=(const MappedFile& other) = delete;
+
+			/**
+			@throws FileNotFoundError If `path` does not exist
+			@throws BadFileError If the file could not be mapped
+			@throws AssertionFailedError If a file is already mapped
+			*/
+			void init(const std::string& path);
+			/**
+			@copydoc MappedFile::init(const std::string&)
+			*/
+			void init(const char* path);
+			void destroy();
+
+			const Byte* getData() const;
+			Size getSize() const;
+
+			bool isCreated() const;
+		private:
+			bool created = false;
+
+			const Byte* data = nullptr;
+			Size size = 0;
+
+#ifdef MACE_WINAPI
+			//file and mapping handles
+			void* file;
+			void* mapping;
+#endif
+		};//MappedFile
+	}//os
+}//mc
+
+#endif//MACE__UTILITY_MAPPED_FILE_H
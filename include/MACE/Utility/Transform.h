@@ -116,6 +116,28 @@ namespace mc {
 		*/
 		Matrix<float, 4> ortho(const float left, const float right, const float bottom, const float top, const float near, const float far);
 
+		/**
+		Creates a matrix that scales, then rotates, then translates a vector. The rotation is the same one that the
+		shaders use, so the result can be composed with other matrices and uploaded as is.
+		<p>
+		Unlike `TransformMatrix::get()`, the scale is applied first and the translation is applied last.
+		@param translation How much to translate
+		@param rotation Rotation in radians around the X, Y, and Z axis
+		@param scale How much to scale
+		@return The combined transformation
+		@see multiply(const Matrix<float, 4>&, const Matrix<float, 4>&)
+		*/
+		Matrix<float, 4> compose(const Vector<float, 3>& translation, const Vector<float, 3>& rotation, const Vector<float, 3>& scale);
+		/**
+		Multiplies 2 `Matrix4f` together. It is the same as `left * right`, but uses SIMD instructions when the compiler
+		supports them.
+		<p>
+		Vectors are multiplied as rows, so the result applies `left` first and `right` last.
+		@param left The transformation applied first
+		@param right The transformation applied last
+		@return The product of both matrices
+		*/
+		Matrix<float, 4> multiply(const Matrix<float, 4>& left, const Matrix<float, 4>& right);
 	}//math
 
 	/**
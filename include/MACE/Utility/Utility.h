@@ -32,6 +32,7 @@ namespace mc {
 #include <MACE/Utility/Transform.h>
 #include <MACE/Utility/Signal.h>
 #include <MACE/Utility/DynamicLibrary.h>
+#include <MACE/Utility/MappedFile.h>
 #include <MACE/Utility/Process.h>
 #include <MACE/Utility/Math.h>
 
@@ -385,6 +385,8 @@ namespace mc {
 		}
 
 		void CallbackComponent::init() {
+			subscribe(Event::HOVER);
+
 			initCallback(parent);
 		}
 
@@ -530,6 +532,8 @@ namespace mc {
 		}
 
 		void FPSComponent::init() {
+			subscribe(Event::HOVER);
+
 			lastTime = std::chrono::steady_clock::now();
 		}
 
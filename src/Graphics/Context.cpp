@@ -164,6 +164,12 @@ namespace mc {
 			model->draw();
 		}
 
+		void Model::drawInstanced(const Size instances) const {
+			MACE__VERIFY_MODEL_INIT();
+
+			model->drawInstanced(instances);
+		}
+
 		bool Model::isCreated() const {
 			MACE__VERIFY_MODEL_INIT();
 
@@ -13,10 +13,43 @@ The above copyright notice and this permission notice shall be included in all c
 #include <MACE/Core/Constants.h>
 #include <MACE/Core/Error.h>
 #include <MACE/Utility/Transform.h>
+#include <atomic>
 #include <string>
 
 namespace mc {
 	namespace gfx{
+		namespace {
+			//entities can subscribe from any thread, but the count is read on the rendering thread
+			std::atomic<Size> subscriberCount{ 0 };
+
+			//0 means that an entity isn't cached
+			std::atomic<Index> nextCacheID{ 1 };
+		}//anon namespace
+
+		SubscriberCounter::SubscriberCounter(const SubscriberCounter&) noexcept {}
+
+		SubscriberCounter::~SubscriberCounter() noexcept {
+			update(false);
+		}
+
+		SubscriberCounter& SubscriberCounter::operator=(const SubscriberCounter&) noexcept {
+			return *this;
+		}
+
+		void SubscriberCounter::update(const bool subscribed) {
+			if (subscribed && !counted) {
+				++subscriberCount;
+			} else if (!subscribed && counted) {
+				--subscriberCount;
+			}
+
+			counted = subscribed;
+		}
+
+		bool SubscriberCounter::hasSubscribers() {
+			return subscriberCount.load() > 0;
+		}
+
 		void Component::init() {}
 
 		bool Component::update() {
@@ -31,6 +64,36 @@ namespace mc {
 
 		void Component::hover() {}
 
+		void Component::onEvent(Event & e) {
+			if (e.type == Event::HOVER) {
+				hover();
+			}
+		}
+
+		void Component::subscribe(const EventMask mask, const bool capture) {
+			if (capture) {
+				captureSubscriptions |= mask;
+			} else {
+				subscriptions |= mask;
+			}
+
+			subscriberCounter.update((subscriptions | captureSubscriptions) != Event::NONE);
+		}
+
+		void Component::unsubscribe(const EventMask mask, const bool capture) {
+			if (capture) {
+				captureSubscriptions &= ~mask;
+			} else {
+				subscriptions &= ~mask;
+			}
+
+			subscriberCounter.update((subscriptions | captureSubscriptions) != Event::NONE);
+		}
+
+		bool Component::isSubscribed(const Event & e) const {
+			return ((e.phase == Event::Phase::CAPTURE ? captureSubscriptions : subscriptions) & e.type) != 0;
+		}
+
 		Entity * Component::getParent() {
 			return parent;
 		}
@@ -63,12 +126,23 @@ namespace mc {
 
 		void Entity::makeChildrenDirty() {
 			setProperty(Entity::DIRTY, true);
+			++revision;
 
 			for (Entity* e : children) {
 				e->makeChildrenDirty();
 			}
 		}
 
+		void Entity::makeResizeDependentsDirty() {
+			for (Entity* e : children) {
+				if (e->isResizeDependent()) {
+					e->makeDirty();
+				} else {
+					e->makeResizeDependentsDirty();
+				}
+			}
+		}
+
 		const std::vector<Entity*>& Entity::getChildren() const {
 			return this->children;
 		}
@@ -126,28 +200,131 @@ namespace mc {
 					clean();
 				}
 
-				onRender();
+				Renderer* const renderer = cacheID == 0 && !parallel ? nullptr : gfx::getCurrentWindow()->getContext()->getRenderer();
+
+				//if the cache is still valid, the renderer draws it instead of the subtree
+				if (cacheID == 0 || renderer->beginCache(this, cacheID, cacheStale)) {
+					if (parallel) {
+						//everything that could call opengl is done here, so the rest can be done on another thread
+						prepare();
+
+						renderer->recordParallel(this);
+					} else {
+						onRender();
+
+						for (Index i = 0; i < children.size(); ++i) {
+							children[i]->render();
+						}
+
+						for (Index i = 0; i < components.size(); ++i) {
+							components[i]->render();
+						}
+					}
+				}
+
+				if (cacheID != 0) {
+					renderer->endCache(this, cacheID);
+				}
+
+				cacheStale = false;
+			}
+
+		}
+
+		void Entity::prepare() {
+			if (!getProperty(Entity::INIT)) {
+				init();
+			}
+
+			if (!getProperty(Entity::DISABLED)) {
+				if (getProperty(Entity::DIRTY)) {
+					clean();
+				}
 
 				for (Index i = 0; i < children.size(); ++i) {
-					children[i]->render();
+					children[i]->prepare();
 				}
 
+				//components run arbitrary code, like the callback of a CallbackComponent, so they stay on this thread
 				for (Index i = 0; i < components.size(); ++i) {
 					components[i]->render();
 				}
 			}
+		}
+
+		void Entity::record() {
+			if (getProperty(Entity::DISABLED)) {
+				return;
+			}
+
+			onRender();
+
+			for (Index i = 0; i < children.size(); ++i) {
+				children[i]->record();
+			}
+		}
+
+		void Event::stopPropagation() {
+			propagating = false;
+		}
+
+		bool Event::isPropagating() const {
+			return propagating;
+		}
+
+		void Entity::handleEvent(Event & e) {
+			e.currentTarget = this;
+
+			if (((e.phase == Event::Phase::CAPTURE ? captureSubscriptions : subscriptions) & e.type) != 0) {
+				onEvent(e);
+			}
+
+			for (Index i = 0; i < components.size(); ++i) {
+				if (components[i]->isSubscribed(e)) {
+					components[i]->onEvent(e);
+				}
+			}
+		}
+
+		void Entity::subscribe(const EventMask mask, const bool capture) {
+			if (capture) {
+				captureSubscriptions |= mask;
+			} else {
+				subscriptions |= mask;
+			}
 
+			subscriberCounter.update((subscriptions | captureSubscriptions) != Event::NONE);
 		}
 
-		void Entity::hover() {
-			onHover();
+		void Entity::unsubscribe(const EventMask mask, const bool capture) {
+			if (capture) {
+				captureSubscriptions &= ~mask;
+			} else {
+				subscriptions &= ~mask;
+			}
+
+			subscriberCounter.update((subscriptions | captureSubscriptions) != Event::NONE);
+		}
+
+		bool Entity::isSubscribed(const Event & e) const {
+			if (((e.phase == Event::Phase::CAPTURE ? captureSubscriptions : subscriptions) & e.type) != 0) {
+				return true;
+			}
+
 			for (Index i = 0; i < components.size(); ++i) {
-				components[i]->hover();
+				if (components[i]->isSubscribed(e)) {
+					return true;
+				}
 			}
+
+			return false;
 		}
 
 		void Entity::clean() {
 			if (getProperty(Entity::DIRTY)) {
+				//parents are cleaned before their children, so the parent's world matrix is already updated
+				updateWorldMatrix();
+
 				onClean();
 
 				for (Size i = 0; i < children.size(); ++i) {
@@ -248,9 +425,47 @@ namespace mc {
 			return m;
 		}
 
+		const Matrix<float, 4>& Entity::getWorldMatrix() const {
+			return worldMatrix;
+		}
+
+		void Entity::updateWorldMatrix() {
+			Vector<float, 3> translation = transformation.translation;
+			Vector<float, 3> scale = transformation.scaler;
+
+			//the window ratios only apply to this entity's own transformation, as every parent already applied theirs
+			if (getProperty(Entity::MAINTAIN_X | Entity::MAINTAIN_Y | Entity::MAINTAIN_WIDTH | Entity::MAINTAIN_HEIGHT)) {
+				const Vector<float, 2> windowRatios = gfx::getCurrentWindow()->getContext()->getRenderer()->getWindowRatios();
+
+				if (getProperty(Entity::MAINTAIN_X)) {
+					translation[0] *= windowRatios[0];
+				}
+				if (getProperty(Entity::MAINTAIN_Y)) {
+					translation[1] *= windowRatios[1];
+				}
+				if (getProperty(Entity::MAINTAIN_WIDTH)) {
+					scale[0] *= windowRatios[0];
+				}
+				if (getProperty(Entity::MAINTAIN_HEIGHT)) {
+					scale[1] *= windowRatios[1];
+				}
+			}
+
+			const Matrix<float, 4> local = math::compose(translation, transformation.rotation, scale);
+
+			if (hasParent()) {
+				worldMatrix = math::multiply(local, getParent()->worldMatrix);
+			} else {
+				worldMatrix = local;
+			}
+		}
+
 		void Entity::reset() {
 			clearChildren();
 			properties = 0;
+			subscriptions = Event::NONE;
+			captureSubscriptions = Event::NONE;
+			subscriberCounter.update(false);
 			transformation.reset();
 
 			for (Index i = 0; i < components.size(); ++i) {
@@ -262,18 +477,75 @@ namespace mc {
 		}
 
 		void Entity::makeDirty() {
+			//counted even if it's already dirty, as it may have been rendered since
+			++revision;
+
 			//checking for the parent can be slow. only want to do the pointer stuff if its not already dirty
 			if (!getProperty(Entity::DIRTY)) {
+				//every cached entity above this one has to render it again
+				cacheStale = true;
+
+				Entity* root = this;
+				while (root->parent != nullptr) {
+					root = root->parent;
+					root->cacheStale = true;
+				}
+
+				const bool rootWasDirty = root->getProperty(Entity::DIRTY);
+
 				setProperty(Entity::DIRTY, true);
+				root->setProperty(Entity::DIRTY, true);
+
+				if (!rootWasDirty) {
+					root->onDirty();
+				}
+			}
+		}
 
-				getRoot()->setProperty(Entity::DIRTY, true);
+		void Entity::setCached(const bool cached) {
+			if (cached == isCached()) {
+				return;
 			}
+
+			cacheID = cached ? nextCacheID++ : 0;
+			cacheStale = true;
+
+			makeDirty();
+		}
+
+		bool Entity::isCached() const {
+			return cacheID != 0;
+		}
+
+		void Entity::setParallel(const bool par) {
+			parallel = par;
+		}
+
+		bool Entity::isParallel() const {
+			return parallel;
+		}
+
+		Size Entity::getRevision() const {
+			return revision;
 		}
 
 		void Entity::onClean() {}
 
+		void Entity::onDirty() {}
+
 		void Entity::onHover() {}
 
+		void Entity::onEvent(Event & e) {
+			if (e.type == Event::HOVER) {
+				onHover();
+			}
+		}
+
+		bool Entity::isResizeDependent() const {
+			return getProperty(Entity::MAINTAIN_X) || getProperty(Entity::MAINTAIN_Y)
+				|| getProperty(Entity::MAINTAIN_WIDTH) || getProperty(Entity::MAINTAIN_HEIGHT);
+		}
+
 		void Entity::setParent(Entity * par) {
 			makeDirty();
 
@@ -378,6 +650,10 @@ namespace mc {
 			return components;
 		}
 
+		const std::vector<SmartPointer<Component>>& Entity::getComponents() const {
+			return components;
+		}
+
 		void Entity::update() {
 			//check if we can update
 			if (!getProperty(Entity::DISABLED)) {
@@ -416,6 +692,7 @@ namespace mc {
 			}
 
 			makeDirty();
+			updateWorldMatrix();
 			for (Index i = 0; i < children.size(); ++i) {
 				children[i]->init();
 			}
@@ -799,7 +799,9 @@ namespace mc {
 			}
 		}
 
-		void Button::onInit() {}
+		void Button::onInit() {
+			subscribe(Event::HOVER_ENTER | Event::HOVER_LEAVE | Event::PRESS | Event::RELEASE);
+		}
 
 		void Button::onUpdate() {}
 
@@ -835,20 +837,42 @@ namespace mc {
 			}
 		}
 
-		void Button::onHover() {
-			hover();
+		void Button::onEvent(Event& e) {
+			if (e.type == Event::HOVER_ENTER) {
+				makeDirty();
 
-			if (gfx::Input::isKeyDown(gfx::Input::MOUSE_LEFT)) {
-				click();
-			}
+				selectableProperties |= Selectable::HOVERED;
+			} else if (e.type == Event::HOVER_LEAVE) {
+				makeDirty();
 
-			if (gfx::Input::isKeyReleased(gfx::Input::MOUSE_LEFT) && isClicked()) {
-				selectableProperties &= ~Selectable::CLICKED;
+				selectableProperties &= ~(Selectable::HOVERED | Selectable::CLICKED);
+			} else if (e.button == gfx::Input::MOUSE_LEFT) {
+				if (e.type == Event::PRESS) {
+					makeDirty();
 
-				trigger();
+					click();
+				} else if (e.type == Event::RELEASE && isClicked()) {
+					makeDirty();
+
+					selectableProperties &= ~Selectable::CLICKED;
+
+					trigger();
+				}
 			}
 		}
 
 		void Button::onClean() {}
+
+		void Button::onClick() {
+			makeDirty();
+		}
+
+		void Button::onEnable() {
+			makeDirty();
+		}
+
+		void Button::onDisable() {
+			makeDirty();
+		}
 	}//gfx
 }//mc
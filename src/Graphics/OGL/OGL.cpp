@@ -8,13 +8,179 @@ Permission is hereby granted, free of charge, to any person obtaining a copy of
 The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
 */
 #include <MACE/Graphics/OGL/OGL.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <string>
 
+//how many texture units have their bindings shadowed. binds to higher units are always sent
+#define MACE__STATE_CACHE_TEXTURE_UNITS 16
+
 namespace mc {
 	namespace gfx {
 		namespace ogl {
 			namespace {
+				//the state isn't known, so whatever is set next must be sent
+				MACE_CONSTEXPR const GLuint UNKNOWN_STATE = ~static_cast<GLuint>(0);
+
+				struct StateCache {
+					GLuint program = UNKNOWN_STATE;
+					GLuint vertexArray = UNKNOWN_STATE;
+					std::unordered_map<Enum, GLuint> buffers{};
+
+					GLuint activeTexture = UNKNOWN_STATE;
+					//only GL_TEXTURE_2D bindings are shadowed
+					std::array<GLuint, MACE__STATE_CACHE_TEXTURE_UNITS> textures;
+
+					std::unordered_map<Enum, bool> capabilities{};
+					Enum blendSource = UNKNOWN_STATE, blendDestination = UNKNOWN_STATE;
+					Enum blendSourceAlpha = UNKNOWN_STATE, blendDestinationAlpha = UNKNOWN_STATE;
+
+					StateCounters counters{};
+
+					StateCache() {
+						textures.fill(UNKNOWN_STATE);
+					}
+				};
+
+				//each thread has it's own context, so each thread has it's own cache
+				thread_local StateCache stateCache{};
+
+				/**
+				@return Whether the new value has to be sent to OpenGL
+				*/
+				template<typename T>
+				bool updateState(T& cached, const T value) {
+					if (cached == value) {
+						++stateCache.counters.skipped;
+						return false;
+					}
+
+					cached = value;
+					++stateCache.counters.issued;
+					return true;
+				}
+
+				bool updateBufferState(const Enum target, const GLuint ID) {
+					auto binding = stateCache.buffers.find(target);
+					if (binding == stateCache.buffers.end()) {
+						stateCache.buffers.insert({ target, ID });
+						++stateCache.counters.issued;
+						return true;
+					}
+
+					return updateState(binding->second, ID);
+				}
+
+				struct ErrorState {
+					//the last place checkGLError() was called. the strings are always literals, so only the pointers are stored
+					Index line = 0;
+					const char* file = "Unknown file";
+					const char* message = "No message specified";
+
+					//what errorCheckMode was when this thread last checked, to know if the debug callback needs to change
+					ErrorCheckMode appliedMode = ErrorCheckMode::NONE;
+					bool callbackInstalled = false;
+
+					//the debug callback may be called from a driver thread
+					std::mutex callbackMutex;
+					std::vector<std::string> callbackErrors;
+					std::atomic<bool> hasCallbackErrors{ false };
+				};
+
+				thread_local ErrorState errorState{};
+
+				void GLAPIENTRY debugCallback(GLenum, GLenum type, GLuint, GLenum, GLsizei length, const GLchar* message, const void* userParam) {
+					if (type != GL_DEBUG_TYPE_ERROR) {
+						return;
+					}
+
+					//userParam is the ErrorState of the thread that installed the callback, as this may be called from another thread
+					ErrorState* state = static_cast<ErrorState*>(const_cast<void*>(userParam));
+
+					const std::unique_lock<std::mutex> guard(state->callbackMutex);
+					state->callbackErrors.push_back(length < 0 ? std::string(message) : std::string(message, static_cast<std::size_t>(length)));
+					state->hasCallbackErrors = true;
+				}
+
+				std::string getCheckpoint() {
+					return " (after " + std::string(errorState.message) + " at " + std::string(errorState.file) + ":" + std::to_string(errorState.line) + ")";
+				}
+
+				void throwCallbackErrors(const Index line, const char* file, const char* message) {
+					if (!errorState.hasCallbackErrors) {
+						return;
+					}
+
+					std::vector<std::string> messages;
+					{
+						const std::unique_lock<std::mutex> guard(errorState.callbackMutex);
+						messages.swap(errorState.callbackErrors);
+						errorState.hasCallbackErrors = false;
+					}
+
+					std::vector<Error> errors;
+					for (const std::string& callbackMessage : messages) {
+						errors.push_back(MACE__GET_ERROR_NAME(OpenGL) (std::string(message) + ": " + callbackMessage + getCheckpoint(), line, file));
+					}
+
+					if (errors.size() == 1) {
+						throw errors[0];
+					} else if (!errors.empty()) {
+						throw MultipleErrors(errors.data(), errors.size(), line, file);
+					}
+				}
+
+				//installs or removes the debug callback on this thread's context if the mode changed
+				ErrorCheckMode applyErrorCheckMode() {
+					ErrorCheckMode mode = errorCheckMode;
+					if (mode == errorState.appliedMode) {
+						return errorState.callbackInstalled || mode != ErrorCheckMode::DEBUG_CALLBACK ? mode : ErrorCheckMode::DEFERRED;
+					}
+
+					const bool supportsCallback = GLEW_KHR_debug || GLEW_VERSION_4_3;
+
+					if (mode == ErrorCheckMode::DEBUG_CALLBACK && supportsCallback && !errorState.callbackInstalled) {
+						//errors that happened before the callback was installed would never be reported otherwise
+						while (glGetError() != GL_NO_ERROR) {}
+
+						glEnable(GL_DEBUG_OUTPUT);
+#ifdef MACE_DEBUG_OPENGL
+						//makes the checkpoint exact, at the cost of speed
+						glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+#endif
+						glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+						glDebugMessageControl(GL_DONT_CARE, GL_DEBUG_TYPE_ERROR, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+						glDebugMessageCallback(&debugCallback, &errorState);
+
+						errorState.callbackInstalled = true;
+					} else if (mode != ErrorCheckMode::DEBUG_CALLBACK && errorState.callbackInstalled) {
+						glDebugMessageCallback(nullptr, nullptr);
+						glDisable(GL_DEBUG_OUTPUT);
+#ifdef MACE_DEBUG_OPENGL
+						glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+#endif
+
+						//the errors were also recorded by glGetError(), but they were already reported by the callback
+						while (glGetError() != GL_NO_ERROR) {}
+
+						errorState.callbackInstalled = false;
+					}
+
+					errorState.appliedMode = mode;
+
+					return mode == ErrorCheckMode::DEBUG_CALLBACK && !errorState.callbackInstalled ? ErrorCheckMode::DEFERRED : mode;
+				}
+
+				//opengl unbinds an object when it is deleted, and it's name can be reused by a new object
+				void forgetBinding(GLuint& cached, const GLuint ID) {
+					if (cached == ID) {
+						cached = 0;
+					}
+				}
+
 				Shader createShader(const Enum type, const char* sources[], const Size sourceSize) {
 					Shader s = Shader(type);
 					s.init();
@@ -51,40 +217,66 @@ namespace mc {
 				}
 			}//anon namespace
 
+			std::atomic<ErrorCheckMode> errorCheckMode{
+#ifdef MACE_DEBUG_OPENGL
+				ErrorCheckMode::IMMEDIATE
+#else
+				ErrorCheckMode::NONE
+#endif
+			};
+
+			void setErrorCheckMode(const ErrorCheckMode mode) {
+				errorCheckMode = mode;
+			}
+
+			ErrorCheckMode getErrorCheckMode() {
+				return errorCheckMode;
+			}
+
 			void forceCheckGLError(const Index line, const char* file, const char* message) {
+				const ErrorCheckMode mode = applyErrorCheckMode();
+
+				if (mode == ErrorCheckMode::DEBUG_CALLBACK) {
+					throwCallbackErrors(line, file, message);
+					return;
+				}
+
+				//deferred errors could have happened anywhere since the last check, so say where the last check was
+				const std::string errorMessage = mode == ErrorCheckMode::DEFERRED ? std::string(message) + getCheckpoint() : std::string(message);
+
 				std::vector<Error> errors;
 
 				Enum result = GL_NO_ERROR;
 				while ((result = glGetError()) != GL_NO_ERROR) {
 					switch (result) {
 						case GL_INVALID_ENUM:
-							errors.push_back(MACE__GET_ERROR_NAME(OpenGL) (std::string(message) + ": GL_INVALID_ENUM: An unacceptable value is specified for an enumerated argument", line, file));
+							errors.push_back(MACE__GET_ERROR_NAME(OpenGL) (errorMessage + ": GL_INVALID_ENUM: An unacceptable value is specified for an enumerated argument", line, file));
 							break;
 						case GL_INVALID_VALUE:
-							errors.push_back(MACE__GET_ERROR_NAME(OpenGL) (std::string(message) + ": GL_INVALID_VALUE: A numeric argument is out of range", line, file));
+							errors.push_back(MACE__GET_ERROR_NAME(OpenGL) (errorMessage + ": GL_INVALID_VALUE: A numeric argument is out of range", line, file));
 							break;
 						case GL_INVALID_OPERATION:
-							errors.push_back(MACE__GET_ERROR_NAME(OpenGL) (std::string(message) + ": GL_INVALID_OPERATION: The specified operation is not allowed in the current state", line, file));
+							errors.push_back(MACE__GET_ERROR_NAME(OpenGL) (errorMessage + ": GL_INVALID_OPERATION: The specified operation is not allowed in the current state", line, file));
 							break;
 						case GL_INVALID_FRAMEBUFFER_OPERATION:
-							errors.push_back(MACE__GET_ERROR_NAME(OpenGL) (std::string(message) + ": GL_INVALID_FRAMEBUFFER_OPERATION: The command is trying to render to or read from the framebuffer while the currently bound framebuffer is not framebuffer complete (i.e. the return value from glCheckFramebufferStatus is not GL_FRAMEBUFFER_COMPLETE)", line, file));
+							errors.push_back(MACE__GET_ERROR_NAME(OpenGL) (errorMessage + ": GL_INVALID_FRAMEBUFFER_OPERATION: The command is trying to render to or read from the framebuffer while the currently bound framebuffer is not framebuffer complete (i.e. the return value from glCheckFramebufferStatus is not GL_FRAMEBUFFER_COMPLETE)", line, file));
 							break;
 						case GL_STACK_OVERFLOW:
-							errors.push_back(MACE__GET_ERROR_NAME(OpenGL) (std::string(message) + ": GL_STACK_OVERFLOW: A stack pushing operation cannot be done because it would overflow the limit of that stack's size", line, file));
+							errors.push_back(MACE__GET_ERROR_NAME(OpenGL) (errorMessage + ": GL_STACK_OVERFLOW: A stack pushing operation cannot be done because it would overflow the limit of that stack's size", line, file));
 							break;
 						case GL_STACK_UNDERFLOW:
-							errors.push_back(MACE__GET_ERROR_NAME(OpenGL) (std::string(message) + ": GL_STACK_UNDERFLOW: A stack popping operation cannot be done because the stack is already at its lowest point", line, file));
+							errors.push_back(MACE__GET_ERROR_NAME(OpenGL) (errorMessage + ": GL_STACK_UNDERFLOW: A stack popping operation cannot be done because the stack is already at its lowest point", line, file));
 							break;
 						case GL_OUT_OF_MEMORY:
-							errors.push_back(MACE__GET_ERROR_NAME(OutOfMemory) (std::string(message) + ": GL_OUT_OF_MEMORY: There is not enough memory left to execute the command", line, file));
+							errors.push_back(MACE__GET_ERROR_NAME(OutOfMemory) (errorMessage + ": GL_OUT_OF_MEMORY: There is not enough memory left to execute the command", line, file));
 							break;
 #ifdef GL_CONTEXT_LOST
 						case GL_CONTEXT_LOST:
-							errors.push_back(MACE__GET_ERROR_NAME(OpenGL) (std::string(message) + ": GL_CONTEXT_LOST: The GL Context has been lost due to a graphics card reset", line, file));
+							errors.push_back(MACE__GET_ERROR_NAME(OpenGL) (errorMessage + ": GL_CONTEXT_LOST: The GL Context has been lost due to a graphics card reset", line, file));
 							break;
 #endif
 						default:
-							errors.push_back(MACE__GET_ERROR_NAME(OpenGL) (std::string(message) + ": OpenGL has errored with an error code of " + std::to_string(result), line, file));
+							errors.push_back(MACE__GET_ERROR_NAME(OpenGL) (errorMessage + ": OpenGL has errored with an error code of " + std::to_string(result), line, file));
 							break;
 					}
 				}
@@ -96,19 +288,36 @@ namespace mc {
 				}
 			}
 
-#ifdef MACE_DEBUG_OPENGL
-			void checkGLError(const Index line, const char* file, const char* message) {
-				forceCheckGLError(line, file, message);
+			void checkGLErrorImpl(const Index line, const char* file, const char* message) {
+				switch (applyErrorCheckMode()) {
+					case ErrorCheckMode::IMMEDIATE:
+						forceCheckGLError(line, file, message);
+						break;
+					case ErrorCheckMode::DEBUG_CALLBACK:
+						throwCallbackErrors(line, file, message);
+						//fallthrough
+					case ErrorCheckMode::DEFERRED:
+						errorState.line = line;
+						errorState.file = file;
+						errorState.message = message;
+						break;
+					case ErrorCheckMode::NONE:
+					default:
+						break;
+				}
 			}
 
 			void checkGLError(const Index line, const char* file, const std::string message) {
-				checkGLError(line, file, message.c_str());
+				const ErrorCheckMode mode = errorCheckMode.load(std::memory_order_relaxed);
+				if (mode == ErrorCheckMode::NONE) {
+					return;
+				} else if (mode == ErrorCheckMode::IMMEDIATE) {
+					forceCheckGLError(line, file, message.c_str());
+				} else {
+					//the string won't outlive this call, so it can't be remembered as the last check
+					checkGLError(line, file, "a check with a dynamic message");
+				}
 			}
-#else
-			void checkGLError(const Index, const char*, const char*) {}
-
-			void checkGLError(const Index, const char*, const std::string&) {}
-#endif
 
 			void VertexArray::init() {
 				glGenVertexArrays(1, &id);
@@ -117,6 +326,12 @@ namespace mc {
 			void VertexArray::destroy() {
 				glDeleteVertexArrays(1, &id);
 
+				if (stateCache.vertexArray == id) {
+					stateCache.vertexArray = 0;
+					//the element buffer binding is part of the vertex array
+					stateCache.buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+				}
+
 				if (indices.isCreated()) {
 					indices.destroy();
 				}
@@ -133,9 +348,10 @@ namespace mc {
 			}
 
 			void VertexArray::loadVertices(const Size verticeSize, const float* vertices, const Index location, const Byte attributeSize, const Enum type, const bool normalized) {
-				vertexNumber = verticeSize;
+				//verticeSize is how many floats there are, and each vertex is made of attributeSize floats
+				vertexNumber = verticeSize / attributeSize;
 
-				storeDataInAttributeList(vertexNumber * sizeof(float), vertices, location, attributeSize, type, normalized);
+				storeDataInAttributeList(verticeSize * sizeof(float), vertices, location, attributeSize, type, normalized);
 			}
 
 			void VertexArray::storeDataInAttributeList(const Size dataSize, const GLvoid* data, const Index location, const Byte attributeSize, const Enum type, const bool normalized) {
@@ -146,7 +362,7 @@ namespace mc {
 				buffer.bind();
 				buffer.setLocation(location);
 				// Give our data to opengl
-				buffer.setData(static_cast<ptrdiff_t>(attributeSize * dataSize), data, GL_DYNAMIC_DRAW);
+				buffer.setData(static_cast<ptrdiff_t>(dataSize), data, GL_DYNAMIC_DRAW);
 				buffer.setAttributePointer(attributeSize, type, normalized, 0, 0);
 
 				addBuffer(buffer);
@@ -212,7 +428,12 @@ namespace mc {
 			}
 
 			void VertexArray::bindIndex(const GLuint ID) const {
-				glBindVertexArray(ID);
+				if (updateState(stateCache.vertexArray, ID)) {
+					glBindVertexArray(ID);
+
+					//the element buffer binding is part of the vertex array
+					stateCache.buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+				}
 			}
 
 			UniformBuffer::UniformBuffer() noexcept : Buffer(GL_UNIFORM_BUFFER) {}
@@ -235,6 +456,9 @@ namespace mc {
 				} else {
 					glBindBufferRange(GL_UNIFORM_BUFFER, this->location, id, offset, size);
 				}
+
+				//binding to an index also binds to the generic binding point
+				stateCache.buffers[GL_UNIFORM_BUFFER] = id;
 			}
 
 			void UniformBuffer::bindToUniformBlock(const Index programID, const char* blockName) const {
@@ -389,6 +613,10 @@ namespace mc {
 
 			void Texture2D::destroy() {
 				glDeleteTextures(1, &id);
+
+				for (GLuint& texture : stateCache.textures) {
+					forgetBinding(texture, id);
+				}
 			}
 
 			void Texture2D::bind() const {
@@ -396,7 +624,10 @@ namespace mc {
 			}
 
 			void Texture2D::bind(const unsigned int location) const {
-				glActiveTexture(GL_TEXTURE0 + location);
+				if (updateState(stateCache.activeTexture, static_cast<GLuint>(location))) {
+					glActiveTexture(GL_TEXTURE0 + location);
+				}
+
 				Object::bind();
 			}
 
@@ -458,7 +689,14 @@ namespace mc {
 			}
 
 			void Texture2D::bindIndex(const GLuint ID) const {
-				glBindTexture(target, ID);
+				if (target == GL_TEXTURE_2D && stateCache.activeTexture < MACE__STATE_CACHE_TEXTURE_UNITS) {
+					if (updateState(stateCache.textures[stateCache.activeTexture], ID)) {
+						glBindTexture(target, ID);
+					}
+				} else {
+					++stateCache.counters.issued;
+					glBindTexture(target, ID);
+				}
 			}
 
 			Buffer::Buffer(const Enum type) noexcept : bufferType(type) {}
@@ -473,6 +711,10 @@ namespace mc {
 
 			void Buffer::destroy() {
 				glDeleteBuffers(1, &id);
+
+				for (auto& binding : stateCache.buffers) {
+					forgetBinding(binding.second, id);
+				}
 			}
 
 			void Buffer::setData(const ptrdiff_t& dataSize, const void* data, const Enum drawType) {
@@ -480,11 +722,18 @@ namespace mc {
 			}
 
 			void Buffer::setDataRange(const Index offset, const ptrdiff_t& dataSize, const void* data) {
-				glBufferSubData(GL_UNIFORM_BUFFER, offset, dataSize, data);
+				glBufferSubData(bufferType, offset, dataSize, data);
 			}
 
 			void Buffer::copyData(Buffer& other, const ptrdiff_t& size, const Index readOffset, const Index writeOffset) {
-				glCopyBufferSubData(id, other.id, readOffset, writeOffset, size);
+				if (updateBufferState(GL_COPY_READ_BUFFER, id)) {
+					glBindBuffer(GL_COPY_READ_BUFFER, id);
+				}
+				if (updateBufferState(GL_COPY_WRITE_BUFFER, other.id)) {
+					glBindBuffer(GL_COPY_WRITE_BUFFER, other.id);
+				}
+
+				glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, readOffset, writeOffset, size);
 			}
 
 			void* Buffer::map(const Enum access) {
@@ -582,7 +831,9 @@ namespace mc {
 			}
 
 			void Buffer::bindIndex(const GLuint ID) const {
-				glBindBuffer(bufferType, ID);
+				if (updateBufferState(bufferType, ID)) {
+					glBindBuffer(bufferType, ID);
+				}
 			}
 
 			VertexBuffer::VertexBuffer() noexcept : Buffer(GL_ARRAY_BUFFER) {}
@@ -817,7 +1068,9 @@ namespace mc {
 			void Shader::bindIndex(const GLuint) const {}
 
 			void ShaderProgram::bindIndex(const GLuint ID) const {
-				glUseProgram(ID);
+				if (updateState(stateCache.program, ID)) {
+					glUseProgram(ID);
+				}
 			}
 
 			void ShaderProgram::init() {
@@ -863,6 +1116,59 @@ namespace mc {
 
 				checkGLError(__LINE__, __FILE__, "Error detaching shader program");
 			}
+			bool ShaderProgram::isBinarySupported() {
+				if (!GLEW_ARB_get_program_binary) {
+					return false;
+				}
+
+				//drivers are allowed to support the extension without supporting any formats
+				GLint formats = 0;
+				glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+				return formats > 0;
+			}
+			void ShaderProgram::setBinaryRetrievable(const bool retrievable) {
+				if (GLEW_ARB_get_program_binary) {
+					glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, retrievable ? GL_TRUE : GL_FALSE);
+				}
+			}
+			std::vector<Byte> ShaderProgram::getBinary(Enum& format) const {
+				if (!GLEW_ARB_get_program_binary) {
+					return std::vector<Byte>();
+				}
+
+				std::vector<Byte> binary = std::vector<Byte>(static_cast<Size>(getParameter(GL_PROGRAM_BINARY_LENGTH)));
+				if (binary.empty()) {
+					return binary;
+				}
+
+				GLsizei written = 0;
+				glGetProgramBinary(id, static_cast<GLsizei>(binary.size()), &written, &format, binary.data());
+				binary.resize(static_cast<Size>(written));
+
+				checkGLError(__LINE__, __FILE__, "Error retrieving shader program binary");
+
+				return binary;
+			}
+			bool ShaderProgram::loadBinary(const Enum format, const Byte* data, const Size length) {
+				if (!isBinarySupported()) {
+					return false;
+				}
+
+				//an unknown format is an error instead of a failed link, so it has to be checked first
+				GLint formatCount = 0;
+				glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+				std::vector<GLint> formats = std::vector<GLint>(static_cast<Size>(formatCount));
+				glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats.data());
+				if (std::find(formats.begin(), formats.end(), static_cast<GLint>(format)) == formats.end()) {
+					return false;
+				}
+
+				glProgramBinary(id, format, data, static_cast<GLsizei>(length));
+
+				checkGLError(__LINE__, __FILE__, "Error loading shader program binary");
+
+				return isLinked();
+			}
 			bool ShaderProgram::isCreated() const {
 				return glIsProgram(id) == GL_TRUE;
 			}
@@ -1228,20 +1534,74 @@ namespace mc {
 			}
 
 			void enable(const Enum param) {
-				glEnable(param);
+				auto capability = stateCache.capabilities.find(param);
+				if (capability == stateCache.capabilities.end()) {
+					stateCache.capabilities.insert({ param, true });
+					++stateCache.counters.issued;
+					glEnable(param);
+				} else if (updateState(capability->second, true)) {
+					glEnable(param);
+				}
 			}
 
 			void disable(const Enum param) {
-				glDisable(param);
+				auto capability = stateCache.capabilities.find(param);
+				if (capability == stateCache.capabilities.end()) {
+					stateCache.capabilities.insert({ param, false });
+					++stateCache.counters.issued;
+					glDisable(param);
+				} else if (updateState(capability->second, false)) {
+					glDisable(param);
+				}
 			}
 
 			void setBlending(const Enum sfactor, const Enum dfactor) {
+				if (stateCache.blendSource == sfactor && stateCache.blendDestination == dfactor
+					&& stateCache.blendSourceAlpha == sfactor && stateCache.blendDestinationAlpha == dfactor) {
+					++stateCache.counters.skipped;
+					return;
+				}
+
+				stateCache.blendSource = sfactor;
+				stateCache.blendDestination = dfactor;
+				stateCache.blendSourceAlpha = sfactor;
+				stateCache.blendDestinationAlpha = dfactor;
+				++stateCache.counters.issued;
 				glBlendFunc(sfactor, dfactor);
 			}
 
+			void setBlending(const Enum sourceColor, const Enum destinationColor, const Enum sourceAlpha, const Enum destinationAlpha) {
+				if (stateCache.blendSource == sourceColor && stateCache.blendDestination == destinationColor
+					&& stateCache.blendSourceAlpha == sourceAlpha && stateCache.blendDestinationAlpha == destinationAlpha) {
+					++stateCache.counters.skipped;
+					return;
+				}
+
+				stateCache.blendSource = sourceColor;
+				stateCache.blendDestination = destinationColor;
+				stateCache.blendSourceAlpha = sourceAlpha;
+				stateCache.blendDestinationAlpha = destinationAlpha;
+				++stateCache.counters.issued;
+				glBlendFuncSeparate(sourceColor, destinationColor, sourceAlpha, destinationAlpha);
+			}
+
 			void setViewport(const Index x, const Index y, const Size width, const Size height) {
 				glViewport(x, y, width, height);
 			}
+
+			const StateCounters& getStateCounters() {
+				return stateCache.counters;
+			}
+
+			void resetStateCounters() {
+				stateCache.counters = StateCounters();
+			}
+
+			void invalidateStateCache() {
+				const StateCounters counters = stateCache.counters;
+				stateCache = StateCache();
+				stateCache.counters = counters;
+			}
 		}//ogl
 	}//gfx
 }//mc
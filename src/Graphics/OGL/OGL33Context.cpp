@@ -121,6 +121,32 @@ namespace mc {
 							MACE__THROW(BadFormat, "Unsupported type by OpenGL");
 					}
 				}
+
+				Enum getPrimitiveType(const Enums::PrimitiveType primitiveType) {
+					using Enums::PrimitiveType;
+
+					if (primitiveType == PrimitiveType::POINTS) {
+						return GL_POINTS;
+					} else if (primitiveType == PrimitiveType::LINES) {
+						return GL_LINES;
+					} else if (primitiveType == PrimitiveType::LINES_ADJACENCY) {
+						return GL_LINES_ADJACENCY;
+					} else if (primitiveType == PrimitiveType::LINES_STRIP) {
+						return GL_LINE_STRIP;
+					} else if (primitiveType == PrimitiveType::LINES_STRIP_ADJACENCY) {
+						return GL_LINE_STRIP_ADJACENCY;
+					} else if (primitiveType == PrimitiveType::TRIANGLES) {
+						return GL_TRIANGLES;
+					} else if (primitiveType == PrimitiveType::TRIANGLES_ADJACENCY) {
+						return GL_TRIANGLES_ADJACENCY;
+					} else if (primitiveType == PrimitiveType::TRIANGLES_STRIP) {
+						return GL_TRIANGLE_STRIP;
+					} else if (primitiveType == PrimitiveType::TRIANGLES_STRIP_ADJACENCY) {
+						return GL_TRIANGLE_STRIP_ADJACENCY;
+					} else {
+						MACE__THROW(UnsupportedRenderer, "Unknown draw mode for OpenGL model: " + std::to_string(static_cast<short int>(primitiveType)));
+					}
+				}
 			}//anon namespace
 
 			OGL33Texture::OGL33Texture(const TextureDesc& desc) : Texture2DImpl(desc), ogl::Texture2D() {
@@ -278,30 +304,7 @@ namespace mc {
 					buffers[i].bind();
 				}
 
-				using Enums::PrimitiveType;
-
-				Enum type;
-				if (primitiveType == PrimitiveType::POINTS) {
-					type = GL_POINTS;
-				} else if (primitiveType == PrimitiveType::LINES) {
-					type = GL_LINES;
-				} else if (primitiveType == PrimitiveType::LINES_ADJACENCY) {
-					type = GL_LINES_ADJACENCY;
-				} else if (primitiveType == PrimitiveType::LINES_STRIP) {
-					type = GL_LINE_STRIP;
-				} else if (primitiveType == PrimitiveType::LINES_STRIP_ADJACENCY) {
-					type = GL_LINE_STRIP_ADJACENCY;
-				} else if (primitiveType == PrimitiveType::TRIANGLES) {
-					type = GL_TRIANGLES;
-				} else if (primitiveType == PrimitiveType::TRIANGLES_ADJACENCY) {
-					type = GL_TRIANGLES_ADJACENCY;
-				} else if (primitiveType == PrimitiveType::TRIANGLES_STRIP) {
-					type = GL_TRIANGLE_STRIP;
-				} else if (primitiveType == PrimitiveType::TRIANGLES_STRIP_ADJACENCY) {
-					type = GL_TRIANGLE_STRIP_ADJACENCY;
-				} else {
-					MACE__THROW(UnsupportedRenderer, "Unknown draw mode for OpenGL model: " + std::to_string(static_cast<short int>(primitiveType)));
-				}
+				const Enum type = getPrimitiveType(primitiveType);
 
 				if (indices.getIndiceNumber() > 0) {
 					indices.bind();
@@ -312,6 +315,22 @@ namespace mc {
 				}
 			}
 
+			void OGL33Model::drawInstanced(const Size instances) const {
+				for (Index i = 0; i < buffers.size(); ++i) {
+					buffers[i].bind();
+				}
+
+				const Enum type = getPrimitiveType(primitiveType);
+
+				if (indices.getIndiceNumber() > 0) {
+					indices.bind();
+
+					glDrawElementsInstanced(type, static_cast<GLsizei>(indices.getIndiceNumber()), GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(instances));
+				} else {
+					glDrawArraysInstanced(type, 0, getVertexNumber(), static_cast<GLsizei>(instances));
+				}
+			}
+
 			void OGL33Model::loadTextureCoordinates(const Size dataSize, const float* data) {
 				ogl::VertexArray::storeDataInAttributeList(dataSize * sizeof(float), data, MACE__VAO_DEFAULT_TEXTURE_COORD_LOCATION, 2);
 			}
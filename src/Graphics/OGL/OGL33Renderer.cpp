@@ -16,8 +16,10 @@ The above copyright notice and this permission notice shall be included in all c
 #endif 
 
 #define MACE_EXPOSE_GLFW
+#define MACE_EXPOSE_OPENGL
 #include <MACE/Graphics/OGL/OGL33Renderer.h>
 #include <MACE/Graphics/Context.h>
+#include <MACE/Utility/MappedFile.h>
 #include <MACE/Core/System.h>
 
 //we need to include algorithim for std::copy
@@ -26,6 +28,20 @@ The above copyright notice and this permission notice shall be included in all c
 #include <cstring>
 //std::begin and std::end
 #include <iterator>
+//offsetof
+#include <cstddef>
+//std::uint64_t
+#include <cstdint>
+//std::cos and std::sin
+#include <cmath>
+//std::numeric_limits
+#include <limits>
+//writing the shader cache
+#include <fstream>
+//timing presentation
+#include <chrono>
+//recording subtrees on other threads
+#include <thread>
 
 //output error messages to console
 #include <sstream>
@@ -37,7 +53,7 @@ namespace mc {
 	namespace gfx {
 		namespace ogl {
 			namespace {
-				//how many floats in the uniform buffer
+				//how many floats in the uniform buffer. the world matrix and the entity ID, padded to a vec4
 #define MACE__ENTITY_DATA_BUFFER_SIZE sizeof(float) * 20
 				//which binding location the uniform buffer goes to
 #define MACE__ENTITY_DATA_LOCATION 0
@@ -45,17 +61,115 @@ namespace mc {
 				//the definition is later stringified. cant be a string because this gets added to the shader.
 #define MACE__ENTITY_DATA_NAME _mc_EntityData
 
-#define MACE__PAINTER_DATA_BUFFER_SIZE sizeof(float) * 56
+#define MACE__PAINTER_DATA_BUFFER_SIZE sizeof(float) * 60
 #define MACE__PAINTER_DATA_LOCATION 1
-#define MACE__PAINTER_DATA_USAGE GL_DYNAMIC_DRAW
+#define MACE__PAINTER_DATA_USAGE GL_STREAM_DRAW
+				//how many painter states each frame can write before the buffer has to grow
+#define MACE__PAINTER_DATA_INITIAL_CAPACITY 1024
 #define MACE__PAINTER_DATA_NAME _mc_PainterData
 
 #define MACE__SCENE_ATTACHMENT_INDEX 0
 #define MACE__ID_ATTACHMENT_INDEX 1
 
-				Shader createShader(const Enum type, const Enums::RenderFeatures features, const char* source) {
-					Shader s = Shader(type);
-					s.init();
+				//how many quads can be in a batch before it has to be flushed
+#define MACE__BATCH_MAXIMUM_QUADS 2048
+
+				//the first 4 bytes of a shader cache file, "MCSC"
+#define MACE__SHADER_CACHE_MAGIC 0x4353434Du
+				//increment if the layout of the shader cache file changes
+#define MACE__SHADER_CACHE_VERSION 1u
+#define MACE__FNV_OFFSET_BASIS 14695981039346656037ULL
+
+				//how much the render scale changes at a time
+#define MACE__RENDER_SCALE_STEP 0.1f
+				//consecutive GPU timings over the budget before the render scale is lowered
+#define MACE__RENDER_SCALE_FRAMES_DOWN 5
+				//consecutive GPU timings under the headroom before the render scale is raised. raising is slower than lowering, so the scale doesn't oscillate
+#define MACE__RENDER_SCALE_FRAMES_UP 60
+				//fraction of the budget a frame has to stay under for the render scale to be raised
+#define MACE__RENDER_SCALE_HEADROOM 0.75f
+
+				//bytes used by each pixel of a render cache, for the color and entity ID
+#define MACE__RENDER_CACHE_PIXEL_SIZE 8
+
+				template<typename Bounds>
+				void combineBounds(Bounds& combined, const Bounds& bounds) {
+					combined.left = std::min(combined.left, bounds.left);
+					combined.bottom = std::min(combined.bottom, bounds.bottom);
+					combined.right = std::max(combined.right, bounds.right);
+					combined.top = std::max(combined.top, bounds.top);
+				}
+
+				//whether every pixel of a draw is known to be fully opaque
+				bool isOpaque(const Enums::Brush brush, const Enums::RenderFeatures features, const Painter::State& state, const InstanceData* instances) {
+					if ((features & Enums::RenderFeatures::FULLY_OPAQUE) != Enums::RenderFeatures::NONE) {
+						return true;
+					}
+
+					//textures and instance colors could have transparent pixels
+					if (brush != Enums::Brush::COLOR || instances != nullptr || state.foregroundColor.a < 1.0f) {
+						return false;
+					}
+
+					//the filter multiplies the color, so it has to leave the alpha as is
+					if ((features & Enums::RenderFeatures::FILTER) != Enums::RenderFeatures::NONE) {
+						return state.filter[3][0] == 0.0f && state.filter[3][1] == 0.0f && state.filter[3][2] == 0.0f && state.filter[3][3] == 1.0f;
+					}
+
+					return true;
+				}
+
+				//least significant digit radix sort, 8 bits at a time. it is stable, so draws with the same key stay in order
+				void radixSort(std::vector<std::pair<std::uint64_t, Index>>& entries, std::vector<std::pair<std::uint64_t, Index>>& scratch) {
+					if (entries.empty()) {
+						return;
+					}
+
+					scratch.resize(entries.size());
+
+					for (unsigned int shift = 0; shift < 64; shift += 8) {
+						Size counts[256] = { 0 };
+						for (const std::pair<std::uint64_t, Index>& entry : entries) {
+							++counts[(entry.first >> shift) & 0xFF];
+						}
+
+						//every key has the same digit, so this pass wouldn't change anything
+						if (counts[(entries.front().first >> shift) & 0xFF] == entries.size()) {
+							continue;
+						}
+
+						Size offset = 0;
+						for (Size& count : counts) {
+							const Size digitCount = count;
+							count = offset;
+							offset += digitCount;
+						}
+
+						for (const std::pair<std::uint64_t, Index>& entry : entries) {
+							scratch[counts[(entry.first >> shift) & 0xFF]++] = entry;
+						}
+
+						entries.swap(scratch);
+					}
+				}
+
+				bool usesTexture(const Enums::Brush brush, const Enums::TextureSlot slot) {
+					switch (brush) {
+						case Enums::Brush::TEXTURE:
+							return slot == Enums::TextureSlot::FOREGROUND;
+						case Enums::Brush::MASK:
+							return slot == Enums::TextureSlot::FOREGROUND || slot == Enums::TextureSlot::MASK;
+						case Enums::Brush::BLEND:
+							return slot == Enums::TextureSlot::FOREGROUND || slot == Enums::TextureSlot::BACKGROUND;
+						case Enums::Brush::MASKED_BLEND:
+							return true;
+						case Enums::Brush::COLOR:
+						default:
+							return false;
+					}
+				}
+
+				std::vector<const char*> getShaderSources(const Enum type, const Enums::RenderFeatures features, const char* source) {
 #define MACE__SHADER_MACRO(name, def) "#define " #name " " MACE_STRINGIFY_DEFINITION(def) "\n"
 					std::vector<const char*> sources = std::vector<const char*>({
 						MACE__SHADER_MACRO(MACE_ENTITY_DATA_LOCATION, MACE__ENTITY_DATA_LOCATION),
@@ -66,6 +180,15 @@ namespace mc {
 						MACE__SHADER_MACRO(MACE_ID_ATTACHMENT_INDEX, MACE__ID_ATTACHMENT_INDEX),
 						MACE__SHADER_MACRO(MACE_VAO_DEFAULT_VERTICES_LOCATION, MACE__VAO_DEFAULT_VERTICES_LOCATION),
 						MACE__SHADER_MACRO(MACE_VAO_DEFAULT_TEXTURE_COORD_LOCATION, MACE__VAO_DEFAULT_TEXTURE_COORD_LOCATION),
+						MACE__SHADER_MACRO(MACE_VAO_INSTANCE_TRANSFORM_LOCATION, MACE__VAO_INSTANCE_TRANSFORM_LOCATION),
+						MACE__SHADER_MACRO(MACE_VAO_INSTANCE_COLOR_LOCATION, MACE__VAO_INSTANCE_COLOR_LOCATION),
+						MACE__SHADER_MACRO(MACE_VAO_BATCH_MATRIX_LOCATION, MACE__VAO_BATCH_MATRIX_LOCATION),
+						MACE__SHADER_MACRO(MACE_VAO_BATCH_FOREGROUND_COLOR_LOCATION, MACE__VAO_BATCH_FOREGROUND_COLOR_LOCATION),
+						MACE__SHADER_MACRO(MACE_VAO_BATCH_FOREGROUND_TRANSFORM_LOCATION, MACE__VAO_BATCH_FOREGROUND_TRANSFORM_LOCATION),
+						MACE__SHADER_MACRO(MACE_VAO_BATCH_MASK_COLOR_LOCATION, MACE__VAO_BATCH_MASK_COLOR_LOCATION),
+						MACE__SHADER_MACRO(MACE_VAO_BATCH_MASK_TRANSFORM_LOCATION, MACE__VAO_BATCH_MASK_TRANSFORM_LOCATION),
+						MACE__SHADER_MACRO(MACE_VAO_BATCH_ENTITY_ID_LOCATION, MACE__VAO_BATCH_ENTITY_ID_LOCATION),
+						MACE__SHADER_MACRO(MACE_VAO_BATCH_DEPTH_LOCATION, MACE__VAO_BATCH_DEPTH_LOCATION),
 #include <MACE/Graphics/OGL/Shaders/Shared.glsl>
 					});
 #undef MACE__SHADER_MACRO
@@ -82,6 +205,12 @@ namespace mc {
 					if ((features & Enums::RenderFeatures::TEXTURE_TRANSFORM) != Enums::RenderFeatures::NONE) {
 						sources.insert(sources.begin(), "#define MACE_TEXTURE_TRANSFORM 1\n");
 					}
+					if ((features & Enums::RenderFeatures::INSTANCED) != Enums::RenderFeatures::NONE) {
+						sources.insert(sources.begin(), "#define MACE_INSTANCED 1\n");
+					}
+					if ((features & Enums::RenderFeatures::BATCHED) != Enums::RenderFeatures::NONE) {
+						sources.insert(sources.begin(), "#define MACE_BATCHED 1\n");
+					}
 
 					sources.insert(sources.begin(), "#version 330 core\n");
 
@@ -100,44 +229,65 @@ namespace mc {
 					}
 #endif
 					sources.push_back(source);
+					return sources;
+				}
+
+				const char* getBrushSource(const Enums::Brush brush) {
+					switch (brush) {
+						case Enums::Brush::COLOR:
+							return
+#	include <MACE/Graphics/OGL/Shaders/Brushes/color.f.glsl>
+								;
+						case Enums::Brush::TEXTURE:
+							return
+#	include <MACE/Graphics/OGL/Shaders/Brushes/texture.f.glsl>
+								;
+						case Enums::Brush::MASK:
+							return
+#	include <MACE/Graphics/OGL/Shaders/Brushes/mask.f.glsl>
+								;
+						case Enums::Brush::BLEND:
+							return
+#	include <MACE/Graphics/OGL/Shaders/Brushes/blend.f.glsl>
+								;
+						case Enums::Brush::MASKED_BLEND:
+							return
+#	include <MACE/Graphics/OGL/Shaders/Brushes/masked_blend.f.glsl>
+								;
+						default:
+							MACE__THROW(BadFormat, "OpenGL 3.3 Renderer: Unsupported brush type: " + std::to_string(static_cast<unsigned int>(brush)));
+					}
+				}
+
+				Shader createShader(const Enum type, std::vector<const char*> sources) {
+					Shader s = Shader(type);
+					s.init();
 					s.setSource(sources.size(), sources.data(), nullptr);
 					s.compile();
 					return s;
 				}
 
-				ogl::ShaderProgram createShadersForSettings(const std::pair<Enums::Brush, Enums::RenderFeatures>& settings) {
-					ogl::ShaderProgram program;
-					program.init();
-
-					program.attachShader(createShader(GL_VERTEX_SHADER, settings.second,
-#include <MACE/Graphics/OGL/Shaders/RenderTypes/standard.v.glsl>
-					));
-
-					if (settings.first == Enums::Brush::COLOR) {
-						program.attachShader(createShader(GL_FRAGMENT_SHADER, settings.second,
-#	include <MACE/Graphics/OGL/Shaders/Brushes/color.f.glsl>
-						));
-
-						program.link();
-					} else if (settings.first == Enums::Brush::TEXTURE) {
-						program.attachShader(createShader(GL_FRAGMENT_SHADER, settings.second,
-#include <MACE/Graphics/OGL/Shaders/Brushes/texture.f.glsl>
-						));
+				//FNV-1a, so the hash of the same sources is the same on every launch
+				std::uint64_t hashSources(std::uint64_t hash, const std::vector<const char*>& sources) {
+					for (const char* source : sources) {
+						for (const char* c = source; *c != '\0'; ++c) {
+							hash ^= static_cast<unsigned char>(*c);
+							hash *= 1099511628211ULL;
+						}
+					}
 
-						program.link();
+					return hash;
+				}
 
+				//uniform values aren't part of a program binary, so this is done whether or not the program was compiled
+				void bindSamplers(ogl::ShaderProgram& program, const Enums::Brush brush) {
+					if (brush == Enums::Brush::TEXTURE) {
 						program.bind();
 
 						program.createUniform("tex");
 
 						program.setUniform("tex", static_cast<int>(Enums::TextureSlot::FOREGROUND));
-					} else if (settings.first == Enums::Brush::MASK) {
-						program.attachShader(createShader(GL_FRAGMENT_SHADER, settings.second,
-#	include <MACE/Graphics/OGL/Shaders/Brushes/mask.f.glsl>
-						));
-
-						program.link();
-
+					} else if (brush == Enums::Brush::MASK) {
 						program.bind();
 
 						program.createUniform("tex");
@@ -146,13 +296,7 @@ namespace mc {
 						//binding the samplers
 						program.setUniform("tex", static_cast<int>(Enums::TextureSlot::FOREGROUND));
 						program.setUniform("mask", static_cast<int>(Enums::TextureSlot::MASK));
-					} else if (settings.first == Enums::Brush::BLEND) {
-						program.attachShader(createShader(GL_FRAGMENT_SHADER, settings.second,
-#	include <MACE/Graphics/OGL/Shaders/Brushes/blend.f.glsl>
-						));
-
-						program.link();
-
+					} else if (brush == Enums::Brush::BLEND) {
 						program.bind();
 
 						program.createUniform("tex1");
@@ -160,13 +304,7 @@ namespace mc {
 
 						program.setUniform("tex1", static_cast<int>(Enums::TextureSlot::FOREGROUND));
 						program.setUniform("tex2", static_cast<int>(Enums::TextureSlot::BACKGROUND));
-					} else if (settings.first == Enums::Brush::MASKED_BLEND) {
-						program.attachShader(createShader(GL_FRAGMENT_SHADER, settings.second,
-#	include <MACE/Graphics/OGL/Shaders/Brushes/masked_blend.f.glsl>
-						));
-
-						program.link();
-
+					} else if (brush == Enums::Brush::MASKED_BLEND) {
 						program.bind();
 
 						program.createUniform("tex1");
@@ -177,17 +315,41 @@ namespace mc {
 						program.setUniform("tex1", static_cast<int>(Enums::TextureSlot::FOREGROUND));
 						program.setUniform("tex2", static_cast<int>(Enums::TextureSlot::BACKGROUND));
 						program.setUniform("mask", static_cast<int>(Enums::TextureSlot::MASK));
-					} else {
-						MACE__THROW(BadFormat, "OpenGL 3.3 Renderer: Unsupported brush type: " + std::to_string(static_cast<unsigned int>(settings.first)));
 					}
+				}
+
+				template<typename T>
+				void writeValue(std::ofstream& out, const T& value) {
+					out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+				}
+
+				//returns false instead of throwing because a truncated cache is recompiled, not an error
+				template<typename T>
+				bool readValue(const Byte*& data, const Byte* end, T& value) {
+					if (static_cast<Size>(end - data) < sizeof(T)) {
+						return false;
+					}
+
+					std::memcpy(&value, data, sizeof(T));
+					data += sizeof(T);
+					return true;
+				}
 
-					ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Error creating shader program for painter");
-					return program;
+				std::string getDriverName() {
+					std::ostringstream name;
+					name << glGetString(GL_VENDOR) << '\n' << glGetString(GL_RENDERER) << '\n' << glGetString(GL_VERSION);
+					return name.str();
 				}
 			}//anon namespace
 
+			thread_local OGL33Renderer::CommandList* OGL33Renderer::recordingList = nullptr;
+
 			OGL33Renderer::OGL33Renderer() {}
 
+			OGL33Renderer::~OGL33Renderer() noexcept {
+				stopRecordingWorkers();
+			}
+
 			void OGL33Renderer::onInit(gfx::WindowModule* win) {
 				glewExperimental = true;
 				const GLenum result = glewInit();
@@ -222,6 +384,9 @@ namespace mc {
 					//see https://www.khronos.org/opengl/wiki/OpenGL_Loading_Library (section GLEW) saying to ignore a GLEW error
 				}
 
+				//this thread has a new context, so nothing it shadowed before is bound anymore
+				ogl::invalidateStateCache();
+
 #ifdef MACE_DEBUG_OPENGL
 				std::cout << os::consoleColor(os::ConsoleColor::LIGHT_GREEN) << "OpenGL Info:" << std::endl;
 				std::cout << os::consoleColor(os::ConsoleColor::LIGHT_GREEN) << "Version: " << std::endl << "\t";
@@ -239,10 +404,33 @@ namespace mc {
 
 				generateFramebuffer(config.width, config.height);
 
+				instanceBuffer.init();
+
+				createPickingBuffers();
+				createUniformBuffers();
+
+				for (ogl::QueryObject& timer : gpuTimers) {
+					timer.init();
+				}
+				createBatchBuffers();
+
+				if (config.shaderCache != nullptr && ogl::ShaderProgram::isBinarySupported()) {
+					shaderCachePath = config.shaderCache;
+					loadShaderCache();
+				}
+
+				warmUpProtocols();
+
 				//gl states
 				ogl::enable(GL_BLEND);
 				ogl::setBlending(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+				//every draw has it's own depth, and triangles of the same draw have to draw over each other
+				ogl::enable(GL_DEPTH_TEST);
+				glDepthFunc(GL_LEQUAL);
+				opaquePass = false;
+				glDepthMask(GL_FALSE);
+
 				ogl::enable(GL_MULTISAMPLE);
 
 				ogl::forceCheckGLError(__LINE__, __FILE__, "An OpenGL error occured initializing OGL33Renderer");
@@ -251,52 +439,111 @@ namespace mc {
 			void OGL33Renderer::onSetUp(gfx::WindowModule *) {
 				ogl::checkGLError(__LINE__, __FILE__, "Internal Error: An error occured before onSetUp");
 
-				frameBuffer.bind();
-				sceneTexture.bind();
-				idTexture.bind();
+				ogl::resetStateCounters();
 
-				frameBuffer.setDrawBuffer(GL_COLOR_ATTACHMENT0 + MACE__SCENE_ATTACHMENT_INDEX);
-				ogl::FrameBuffer::setClearColor(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
-				ogl::FrameBuffer::clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+				beginGPUTimer();
+				updateRenderScale();
 
-				ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Failed to clear color buffer");
+				//picking needs the id attachment, and a scaled frame has to be drawn offscreen to be upscaled. only a frame
+				//with neither is drawn straight to the window
+				offscreen = picking || renderScale < 1.0f;
 
-				//we want to clear the id texture to black only - not the color set by the user. this requires 3 setDrawBuffers - which is annoying
-				frameBuffer.setDrawBuffer(GL_COLOR_ATTACHMENT0 + MACE__ID_ATTACHMENT_INDEX);
-				ogl::FrameBuffer::setClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-				ogl::FrameBuffer::clear(GL_COLOR_BUFFER_BIT);
+				sceneWidth = offscreen ? getScaledSize(framebufferWidth) : framebufferWidth;
+				sceneHeight = offscreen ? getScaledSize(framebufferHeight) : framebufferHeight;
 
-				ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Failed to clear ID buffer");
+				//subtrees from a frame that threw while recording
+				waitForRecordings();
 
-				MACE_CONSTEXPR const Enum drawBuffers[] = {
-					GL_COLOR_ATTACHMENT0 + MACE__SCENE_ATTACHMENT_INDEX,
-					GL_COLOR_ATTACHMENT0 + MACE__ID_ATTACHMENT_INDEX
-				};
-				frameBuffer.setDrawBuffers(2, drawBuffers);
+				++frameNumber;
+				cacheTargets.clear();
+				cacheStack.clear();
+
+				usedCommandLists = 0;
+				currentList = beginCommandList();
+
+				//the depth buffer is only cleared while depth writes are enabled
+				bindPass(true);
+
+				if (!offscreen) {
+					//nothing needs entity IDs, so the frame is drawn straight to the window and never has to be blitted
+					frameBuffer.unbind();
+					ogl::FrameBuffer::setDrawBuffer(GL_BACK);
+					ogl::FrameBuffer::setClearColor(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
+					ogl::FrameBuffer::clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+					ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Failed to clear the window");
+				} else {
+					frameBuffer.bind();
+					sceneTexture.bind();
+					idTexture.bind();
+
+					frameBuffer.setDrawBuffer(GL_COLOR_ATTACHMENT0 + MACE__SCENE_ATTACHMENT_INDEX);
+					ogl::FrameBuffer::setClearColor(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
+					ogl::FrameBuffer::clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+					ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Failed to clear color buffer");
+
+					//we want to clear the id texture to black only - not the color set by the user. this requires 3 setDrawBuffers - which is annoying
+					frameBuffer.setDrawBuffer(GL_COLOR_ATTACHMENT0 + MACE__ID_ATTACHMENT_INDEX);
+					ogl::FrameBuffer::setClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+					ogl::FrameBuffer::clear(GL_COLOR_BUFFER_BIT);
 
-				ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Failed to set draw buffers for framebuffer");
+					ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Failed to clear ID buffer");
+				}
+
+				boundTarget = 0;
+				bindTarget(0);
+
+				frameStatistics.renderScale = offscreen ? renderScale : 1.0f;
+
+				uploadEntityData();
+				boundEntity = 0;
 
+				beginPainterDataFrame();
 			}
 
 			void OGL33Renderer::onTearDown(gfx::WindowModule * win) {
+				submitCommands();
+
+				//every draw that read painter data this frame has been submitted
+				endPainterDataFrame();
+
 				ogl::checkGLError(__LINE__, __FILE__, "Error occured during rendering");
 
-				frameBuffer.unbind();
+				if (offscreen) {
+					frameBuffer.unbind();
+
+					ogl::FrameBuffer::clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+					const int width = framebufferWidth, height = framebufferHeight;
+					const int scaledWidth = getScaledSize(width), scaledHeight = getScaledSize(height);
 
-				ogl::FrameBuffer::clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+					glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+					glBindFramebuffer(GL_READ_FRAMEBUFFER, frameBuffer.getID());
+					ogl::FrameBuffer::setReadBuffer(GL_COLOR_ATTACHMENT0 + MACE__SCENE_ATTACHMENT_INDEX);
+					ogl::FrameBuffer::setDrawBuffer(GL_BACK);
 
-				int width, height;
-				glfwGetWindowSize(win->getGLFWWindow(), &width, &height);
+					//nothing reads the depth of the window after this, and blitting depth between different formats can fail
+					if (scaledWidth == width && scaledHeight == height) {
+						glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+					} else {
+						glBlitFramebuffer(0, 0, scaledWidth, scaledHeight, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+					}
+					ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Failed to tear down renderer");
+				}
+
+				//the id texture was redrawn, so it has to be copied again even if the mouse didn't move
+				pickingStale = true;
 
-				glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-				glBindFramebuffer(GL_READ_FRAMEBUFFER, frameBuffer.getID());
-				ogl::FrameBuffer::setReadBuffer(GL_COLOR_ATTACHMENT0 + MACE__SCENE_ATTACHMENT_INDEX);
-				ogl::FrameBuffer::setDrawBuffer(GL_BACK);
+				endGPUTimer();
 
-				glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, GL_NEAREST);
-				ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Failed to tear down renderer");
+				const ogl::StateCounters& counters = ogl::getStateCounters();
+				frameStatistics.stateChanges = counters.issued;
+				frameStatistics.skippedStateChanges = counters.skipped;
 
+				const std::chrono::steady_clock::time_point presentStart = std::chrono::steady_clock::now();
 				glfwSwapBuffers(win->getGLFWWindow());
+				frameStatistics.presentTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - presentStart).count();
 
 				ogl::forceCheckGLError(__LINE__, __FILE__, "An OpenGL error occurred during a rendering frame");
 			}
@@ -314,10 +561,15 @@ namespace mc {
 
 				generateFramebuffer(width == 0 ? 1 : width, height == 0 ? 1 : height);
 
+				pickingStale = true;
+
 				ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Error resizing framebuffer for renderer");
 			}
 
 			void OGL33Renderer::onDestroy() {
+				waitForRecordings();
+				stopRecordingWorkers();
+
 				depthBuffer.destroy();
 
 				frameBuffer.destroy();
@@ -325,6 +577,26 @@ namespace mc {
 				sceneTexture.destroy();
 				idTexture.destroy();
 
+				instanceBuffer.destroy();
+				instanceCapacity = 0;
+
+				destroyPickingBuffers();
+
+				for (ogl::QueryObject& timer : gpuTimers) {
+					timer.destroy();
+				}
+				gpuTimersPending.fill(false);
+
+				for (auto iter = renderCaches.begin(); iter != renderCaches.end(); ++iter) {
+					destroyCache(iter->second);
+				}
+				renderCaches.clear();
+
+				destroyBatchBuffers();
+				destroyUniformBuffers();
+
+				saveShaderCache();
+
 				for (auto iter = protocols.begin(); iter != protocols.end(); ++iter) {
 					iter->second.program.destroy();
 				}
@@ -344,7 +616,8 @@ namespace mc {
 			void OGL33Renderer::generateFramebuffer(const int width, const int height) {
 				depthBuffer.init();
 				depthBuffer.bind();
-				depthBuffer.setStorage(GL_DEPTH_COMPONENT, width, height);
+				//every draw of a frame needs a different depth
+				depthBuffer.setStorage(GL_DEPTH_COMPONENT24, width, height);
 
 				ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Error creating depth buffers for renderer");
 
@@ -419,6 +692,9 @@ namespace mc {
 
 				ogl::setViewport(0, 0, width, height);
 
+				framebufferWidth = width;
+				framebufferHeight = height;
+
 				const gfx::WindowModule::LaunchConfig& config = context->getWindow()->getLaunchConfig();
 
 				windowRatios = {
@@ -431,206 +707,1742 @@ namespace mc {
 			}
 
 			GraphicsEntity * OGL33Renderer::getEntityAt(const int x, const int y) {
-				frameBuffer.bind();
+				readPickingBuffers();
 
-				Vector<int, 2> framebufferSize = getContext()->getWindow()->getFramebufferSize();
+				//the id texture wasn't written last frame
+				if (!picking) {
+					return nullptr;
+				}
 
-				EntityID pixel = 0;
-				ogl::FrameBuffer::setReadBuffer(GL_COLOR_ATTACHMENT0 + MACE__ID_ATTACHMENT_INDEX);
-				ogl::FrameBuffer::setDrawBuffer(GL_COLOR_ATTACHMENT0 + MACE__ID_ATTACHMENT_INDEX);
-				//opengl y-axis is inverted from window coordinates
-				frameBuffer.readPixels(x, framebufferSize.y() - y, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, &pixel);
+				const Vector<int, 2> framebufferSize = getContext()->getWindow()->getFramebufferSize();
+				if (x < 0 || y < 0 || x >= framebufferSize.x() || y >= framebufferSize.y()) {
+					return nullptr;
+				}
+
+				//if neither the mouse nor the scene changed, the last copy is still correct
+				//the id texture only covers the bottom left of the framebuffer if the frame was scaled
+				if ((pickingStale || x != pickingX || y != pickingY)
+					&& requestPick(static_cast<int>(static_cast<float>(x) * frameStatistics.renderScale),
+						static_cast<int>(static_cast<float>(framebufferSize.y() - 1 - y) * frameStatistics.renderScale))) {
+					pickingX = x;
+					pickingY = y;
+					pickingStale = false;
+				}
+
+				//the copy is a frame or 2 old, so the entity that was there may have been removed and it's ID given to another
+				return getPickedEntity(pickedEntity, pickedFrame);
+			}
+
+			void OGL33Renderer::beginGPUTimer() {
+				gpuTimeUpdated = false;
 
-				if (pixel > 0) {
-					//this could happen if the entity that was there was removed from the renderqueue
-					//in between onRender() and getEntityAt()
-					if (pixel > renderQueue.size()) {
-						return nullptr;
+				//timers finish in the order they were started, so the first one that isn't done means the rest aren't either
+				for (Index i = 0; i < MACE__GPU_TIMER_QUERIES; ++i) {
+					const Index index = (gpuTimerIndex + i) % MACE__GPU_TIMER_QUERIES;
+					if (!gpuTimersPending[index]) {
+						continue;
 					}
 
-					return renderQueue[--pixel];
+					GLint available = GL_FALSE;
+					gpuTimers[index].get(GL_QUERY_RESULT_AVAILABLE, &available);
+					if (available == GL_FALSE) {
+						break;
+					}
+
+					GLuint64 nanoseconds = 0;
+					gpuTimers[index].get(GL_QUERY_RESULT, &nanoseconds);
+					lastGPUTime = static_cast<float>(nanoseconds) / 1000000.0f;
+					gpuTimeUpdated = true;
+
+					gpuTimersPending[index] = false;
+
+					if (staleGPUTimings > 0) {
+						--staleGPUTimings;
+					}
 				}
 
-				return nullptr;
+				frameStatistics.gpuTime = lastGPUTime;
+
+				//the GPU is more than MACE__GPU_TIMER_QUERIES frames behind, so this frame isn't timed instead of waiting
+				timingFrame = !gpuTimersPending[gpuTimerIndex];
+				if (timingFrame) {
+					gpuTimers[gpuTimerIndex].begin(GL_TIME_ELAPSED);
+				}
 			}
 
-			std::shared_ptr<PainterImpl> OGL33Renderer::createPainterImpl(Painter* const p) {
-				return std::shared_ptr<PainterImpl>(new OGL33Painter(this, p));
+			void OGL33Renderer::endGPUTimer() {
+				if (!timingFrame) {
+					return;
+				}
+
+				gpuTimers[gpuTimerIndex].end(GL_TIME_ELAPSED);
+				gpuTimersPending[gpuTimerIndex] = true;
+				gpuTimerIndex = (gpuTimerIndex + 1) % MACE__GPU_TIMER_QUERIES;
+
+				timingFrame = false;
 			}
 
-			void OGL33Renderer::bindProtocol(OGL33Painter* painter, const std::pair<Enums::Brush, Enums::RenderFeatures> settings) {
-				auto protocol = protocols.find(settings);
-				if (protocol == protocols.end()) {
-					RenderProtocol prot = RenderProtocol();
-					prot.program = createShadersForSettings(settings);
+			void OGL33Renderer::updateRenderScale() {
+				const WindowModule::LaunchConfig& config = context->getWindow()->getLaunchConfig();
+				if (config.gpuBudget <= 0.0f) {
+					renderScale = 1.0f;
+					return;
+				}
+
+				//every timing is only counted once, and timings from before the last change don't reflect the current scale
+				if (!gpuTimeUpdated || staleGPUTimings > 0) {
+					return;
+				}
 
-					painter->painterData.bindToUniformBlock(prot.program, MACE_STRINGIFY_DEFINITION(MACE__PAINTER_DATA_NAME));
-					painter->entityData.bindToUniformBlock(prot.program, MACE_STRINGIFY_DEFINITION(MACE__ENTITY_DATA_NAME));
+				const float minimumScale = std::min(std::max(config.minimumRenderScale, MACE__RENDER_SCALE_STEP), 1.0f);
 
-					protocols.insert(std::pair<std::pair<Enums::Brush, Enums::RenderFeatures>, OGL33Renderer::RenderProtocol>(settings, prot));
+				if (lastGPUTime > config.gpuBudget) {
+					framesUnderBudget = 0;
+					if (++framesOverBudget < MACE__RENDER_SCALE_FRAMES_DOWN || renderScale <= minimumScale) {
+						return;
+					}
+
+					renderScale = std::max(renderScale - MACE__RENDER_SCALE_STEP, minimumScale);
+				} else if (lastGPUTime < config.gpuBudget * MACE__RENDER_SCALE_HEADROOM) {
+					framesOverBudget = 0;
+					if (++framesUnderBudget < MACE__RENDER_SCALE_FRAMES_UP || renderScale >= 1.0f) {
+						return;
+					}
 
-					protocol = protocols.find(settings);
+					renderScale = std::min(renderScale + MACE__RENDER_SCALE_STEP, 1.0f);
+				} else {
+					framesOverBudget = 0;
+					framesUnderBudget = 0;
+					return;
 				}
 
-				protocol->second.program.bind();
+				framesOverBudget = 0;
+				framesUnderBudget = 0;
+				staleGPUTimings = MACE__GPU_TIMER_QUERIES;
+			}
 
-				return;
+			int OGL33Renderer::getScaledSize(const int size) const {
+				return std::max(1, static_cast<int>(static_cast<float>(size) * renderScale + 0.5f));
 			}
 
-			OGL33Painter::OGL33Painter(OGL33Renderer* const r, Painter* const p) : PainterImpl(p), renderer(r) {}
+			bool OGL33Renderer::hasPendingResults() const {
+				for (const GLsync fence : pickingFences) {
+					if (fence != nullptr) {
+						return true;
+					}
+				}
 
-			void OGL33Painter::init() {
-				createPainterData();
-				createEntityData();
+				return false;
 			}
 
-			void OGL33Painter::createEntityData() {
-				MACE_STATIC_ASSERT(sizeof(float) >= sizeof(EntityID), "This system doesn't not support the required size for EntityID");
+			void OGL33Renderer::createPickingBuffers() {
+				for (ogl::PixelPackBuffer& buffer : pickingBuffers) {
+					buffer.init();
+					buffer.bind();
+					buffer.setData(static_cast<ptrdiff_t>(sizeof(GLuint)), nullptr, GL_STREAM_READ);
+					buffer.unbind();
+				}
 
-				savedMetrics = painter->getEntity()->getMetrics();
+				pickingIndex = 0;
+				pickedEntity = 0;
+				pickedFrame = 0;
+				pickingStale = true;
 
-				entityData.init();
-				entityData.bind();
+				ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Failed to create picking buffers");
+			}
 
-				float entityDataBuffer[MACE__ENTITY_DATA_BUFFER_SIZE / sizeof(float)] = {};
+			void OGL33Renderer::destroyPickingBuffers() {
+				for (Index i = 0; i < MACE__PICKING_BUFFERS; ++i) {
+					if (pickingFences[i] != nullptr) {
+						glDeleteSync(pickingFences[i]);
+						pickingFences[i] = nullptr;
+					}
 
-				savedMetrics.translation.flatten(entityDataBuffer);
-				//offset by 4
-				savedMetrics.rotation.flatten(entityDataBuffer + 4);
-				savedMetrics.inheritedTranslation.flatten(entityDataBuffer + 8);
-				savedMetrics.inheritedRotation.flatten(entityDataBuffer + 12);
-				savedMetrics.scale.flatten(entityDataBuffer + 16);
-				//this crazy line puts a GLuint directly into a float, as GLSL expects a uint instead of a float
-				*reinterpret_cast<GLuint*>(entityDataBuffer + 19) = static_cast<GLuint>(painter->getID());
+					pickingBuffers[i].destroy();
+				}
+			}
 
-				//we set it to null, because during the actual rendering we set the data
-				entityData.setData(MACE__ENTITY_DATA_BUFFER_SIZE, entityDataBuffer, MACE__ENTITY_DATA_USAGE);
+			void OGL33Renderer::readPickingBuffers() {
+				//copies finish in the order they were made, so the first one that isn't done means the rest aren't either
+				for (Index i = 0; i < MACE__PICKING_BUFFERS; ++i) {
+					const Index index = (pickingIndex + i) % MACE__PICKING_BUFFERS;
+					GLsync& fence = pickingFences[index];
+					if (fence == nullptr) {
+						continue;
+					}
 
-				entityData.setLocation(MACE__ENTITY_DATA_LOCATION);
+					const GLenum result = glClientWaitSync(fence, 0, 0);
+					if (result == GL_TIMEOUT_EXPIRED) {
+						break;
+					} else if (result == GL_WAIT_FAILED) {
+						ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Failed to check picking fence");
+					}
+
+					glDeleteSync(fence);
+					fence = nullptr;
+
+					GLuint pixel = 0;
+					pickingBuffers[index].bind();
+					const void* mapped = pickingBuffers[index].mapRange(0, sizeof(GLuint), GL_MAP_READ_BIT);
+					if (mapped != nullptr) {
+						std::memcpy(&pixel, mapped, sizeof(GLuint));
+					}
+					pickingBuffers[index].unmap();
+					pickingBuffers[index].unbind();
+
+					pickedEntity = static_cast<EntityID>(pixel);
+					pickedFrame = pickingFrames[index];
+				}
+
+				ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Failed to read picking buffers");
 			}
 
-			void OGL33Painter::createPainterData() {
-				savedState = painter->getState();
+			bool OGL33Renderer::requestPick(const int x, const int y) {
+				if (pickingFences[pickingIndex] != nullptr) {
+					return false;
+				}
 
-				painterData.init();
-				painterData.bind();
+				frameBuffer.bind();
+				ogl::FrameBuffer::setReadBuffer(GL_COLOR_ATTACHMENT0 + MACE__ID_ATTACHMENT_INDEX);
 
-				float painterDataBuffer[MACE__PAINTER_DATA_BUFFER_SIZE / sizeof(float)] = { 0 };
+				//with a pixel pack buffer bound, the last argument is an offset into it and glReadPixels returns immediately
+				pickingBuffers[pickingIndex].bind();
+				frameBuffer.readPixels(x, y, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+				pickingBuffers[pickingIndex].unbind();
 
-				savedState.transformation.translation.flatten(painterDataBuffer);
-				savedState.transformation.rotation.flatten(painterDataBuffer + 4);
-				savedState.transformation.scaler.flatten(painterDataBuffer + 8);
-				savedState.data.flatten(painterDataBuffer + 12);
-				savedState.foregroundColor.flatten(painterDataBuffer + 16);
-				savedState.foregroundTransform.flatten(painterDataBuffer + 20);
-				savedState.backgroundColor.flatten(painterDataBuffer + 24);
-				savedState.backgroundTransform.flatten(painterDataBuffer + 28);
-				savedState.maskColor.flatten(painterDataBuffer + 32);
-				savedState.maskTransform.flatten(painterDataBuffer + 36);
-				savedState.filter.flatten(painterDataBuffer + 40);
-
-				//we set it to null, because during the actual rendering we set the data
-				painterData.setData(MACE__PAINTER_DATA_BUFFER_SIZE, painterDataBuffer, MACE__PAINTER_DATA_USAGE);
+				pickingFences[pickingIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+				//the framebuffer still has the last frame that was rendered
+				pickingFrames[pickingIndex] = frameCount;
+				pickingIndex = (pickingIndex + 1) % MACE__PICKING_BUFFERS;
 
-				painterData.setLocation(MACE__PAINTER_DATA_LOCATION);
-			}
+				ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Failed to copy the entity under the mouse");
 
-			void OGL33Painter::destroy() {
-				painterData.destroy();
-				entityData.destroy();
+				return true;
 			}
 
-			void OGL33Painter::begin() {
-				painterData.bind();
-				painterData.bindForRender();
+			void OGL33Renderer::bindInstances(const InstanceData* instances, const Size count) {
+				instanceBuffer.bind();
 
-				entityData.bind();
-				entityData.bindForRender();
+				if (count > instanceCapacity) {
+					//grow geometrically so emitters that slowly gain particles dont reallocate every frame
+					instanceCapacity = std::max(count, instanceCapacity * 2);
+				}
+
+				//orphan the old storage every time so the driver doesnt have to wait for the last draw to finish with it
+				instanceBuffer.setData(static_cast<ptrdiff_t>(sizeof(InstanceData) * instanceCapacity), nullptr, GL_STREAM_DRAW);
+				instanceBuffer.setDataRange(0, static_cast<ptrdiff_t>(sizeof(InstanceData) * count), instances);
+
+				instanceBuffer.setLocation(MACE__VAO_INSTANCE_TRANSFORM_LOCATION);
+				instanceBuffer.setAttributePointer(4, GL_FLOAT, false, sizeof(InstanceData), nullptr);
+				instanceBuffer.setDivisor(1);
+				instanceBuffer.enable();
+
+				instanceBuffer.setLocation(MACE__VAO_INSTANCE_COLOR_LOCATION);
+				instanceBuffer.setAttributePointer(4, GL_FLOAT, false, sizeof(InstanceData), reinterpret_cast<const void*>(sizeof(float) * 4));
+				instanceBuffer.setDivisor(1);
+				instanceBuffer.enable();
+
+				ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Failed to upload instance data");
 			}
 
-			void OGL33Painter::end() {}
+			void OGL33Renderer::unbindInstances() {
+				//the model's vertex array is shared with non-instanced draws, so the attributes must not stay enabled
+				instanceBuffer.setLocation(MACE__VAO_INSTANCE_TRANSFORM_LOCATION);
+				instanceBuffer.disable();
 
-			void OGL33Painter::clean() {
-				if (!painter->getEntity()->getProperty(Entity::INIT)) {
-					MACE__THROW(InitializationFailed, "Entity is not initializd.");
-				}
+				instanceBuffer.setLocation(MACE__VAO_INSTANCE_COLOR_LOCATION);
+				instanceBuffer.disable();
+			}
 
-				const Entity::Metrics metrics = painter->getEntity()->getMetrics();
+			std::shared_ptr<PainterImpl> OGL33Renderer::createPainterImpl(Painter* const p) {
+				return std::shared_ptr<PainterImpl>(new OGL33Painter(this, p));
+			}
 
-				if (metrics == savedMetrics) {
+			void OGL33Renderer::bindProtocol(const std::pair<Enums::Brush, Enums::RenderFeatures> settings) {
+				//sorted draws usually use the same program as the last one
+				if (boundProtocol != nullptr && boundSettings == settings) {
 					return;
 				}
 
-				//now we set the uniforms defining the transformations of the entity
-				entityData.bind();
+				auto protocol = protocols.find(settings);
+				RenderProtocol& prot = protocol == protocols.end() ? createProtocol(settings) : protocol->second;
 
-				if (metrics.translation != savedMetrics.translation) {
-					entityData.setDataRange(0, sizeof(float) * 3, metrics.translation.begin());
-				}
-				if (metrics.rotation != savedMetrics.rotation) {
-					entityData.setDataRange(sizeof(float) * 4, sizeof(float) * 3, metrics.rotation.begin());
+				prot.program.bind();
+
+				boundProtocol = &prot;
+				boundSettings = settings;
+
+				++frameStatistics.programBinds;
+			}
+
+			OGL33Renderer::RenderProtocol& OGL33Renderer::createProtocol(const std::pair<Enums::Brush, Enums::RenderFeatures> settings) {
+				RenderProtocol prot = RenderProtocol();
+				prot.program = createProgram(settings);
+
+				//the binding only depends on the location, so it doesn't matter which buffer is used to set it
+				painterData.bindToUniformBlock(prot.program, MACE_STRINGIFY_DEFINITION(MACE__PAINTER_DATA_NAME));
+				//batched draws get their entity data from instance attributes, so their shaders don't have the block
+				if ((settings.second & Enums::RenderFeatures::BATCHED) == Enums::RenderFeatures::NONE) {
+					entityData.bindToUniformBlock(prot.program, MACE_STRINGIFY_DEFINITION(MACE__ENTITY_DATA_NAME));
+
+					prot.program.bind();
+					prot.program.createUniform("_mc_DrawDepth");
+					prot.depthLocation = prot.program.getUniformLocation("_mc_DrawDepth");
 				}
-				if (metrics.inheritedTranslation != savedMetrics.inheritedTranslation) {
-					entityData.setDataRange(sizeof(float) * 8, sizeof(float) * 3, metrics.inheritedTranslation.begin());
+
+				return protocols.insert(std::pair<std::pair<Enums::Brush, Enums::RenderFeatures>, OGL33Renderer::RenderProtocol>(settings, prot)).first->second;
+			}
+
+			ogl::ShaderProgram OGL33Renderer::createProgram(const std::pair<Enums::Brush, Enums::RenderFeatures> settings) {
+				std::vector<const char*> vertexSources = getShaderSources(GL_VERTEX_SHADER, settings.second,
+#include <MACE/Graphics/OGL/Shaders/RenderTypes/standard.v.glsl>
+				);
+				std::vector<const char*> fragmentSources = getShaderSources(GL_FRAGMENT_SHADER, settings.second, getBrushSource(settings.first));
+
+				const std::uint64_t sourceHash = hashSources(hashSources(MACE__FNV_OFFSET_BASIS, vertexSources), fragmentSources);
+
+				ogl::ShaderProgram program;
+				program.init();
+
+				bool loaded = false;
+
+				const auto binary = programBinaries.find(settings);
+				if (binary != programBinaries.end() && binary->second.sourceHash == sourceHash) {
+					loaded = program.loadBinary(binary->second.format, binary->second.data.data(), binary->second.data.size());
 				}
-				if (metrics.inheritedRotation != savedMetrics.inheritedRotation) {
-					entityData.setDataRange(sizeof(float) * 12, sizeof(float) * 3, metrics.inheritedRotation.begin());
+
+				if (!loaded) {
+					program.attachShader(createShader(GL_VERTEX_SHADER, vertexSources));
+					program.attachShader(createShader(GL_FRAGMENT_SHADER, fragmentSources));
+
+					if (!shaderCachePath.empty()) {
+						program.setBinaryRetrievable(true);
+					}
+
+					program.link();
+
+					if (!shaderCachePath.empty()) {
+						ProgramBinary& newBinary = programBinaries[settings];
+						newBinary.sourceHash = sourceHash;
+						newBinary.data = program.getBinary(newBinary.format);
+
+						shaderCacheChanged = true;
+					}
 				}
-				if (metrics.scale != savedMetrics.scale) {
-					entityData.setDataRange(sizeof(float) * 16, sizeof(float) * 3, metrics.scale.begin());
+
+				bindSamplers(program, settings.first);
+
+				ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Error creating shader program for painter");
+				return program;
+			}
+
+			void OGL33Renderer::warmUpProtocols() {
+				const Enums::RenderFeatures colorFeatures = Enums::RenderFeatures::DEFAULT & ~Enums::RenderFeatures::TEXTURE;
+				const Enums::RenderFeatures textureFeatures = Enums::RenderFeatures::DEFAULT | Enums::RenderFeatures::DISCARD_INVISIBLE;
+
+				//what the Painter and the built in entities draw with, including the batched and instanced versions
+				const std::pair<Enums::Brush, Enums::RenderFeatures> commonSettings[] = {
+					{ Enums::Brush::COLOR, colorFeatures },
+					{ Enums::Brush::COLOR, colorFeatures | Enums::RenderFeatures::BATCHED },
+					{ Enums::Brush::COLOR, colorFeatures | Enums::RenderFeatures::INSTANCED },
+					{ Enums::Brush::TEXTURE, textureFeatures },
+					{ Enums::Brush::TEXTURE, textureFeatures | Enums::RenderFeatures::BATCHED },
+					{ Enums::Brush::TEXTURE, textureFeatures | Enums::RenderFeatures::INSTANCED },
+					{ Enums::Brush::MASK, Enums::RenderFeatures::DEFAULT },
+					{ Enums::Brush::MASK, Enums::RenderFeatures::DEFAULT | Enums::RenderFeatures::BATCHED },
+					{ Enums::Brush::BLEND, Enums::RenderFeatures::DEFAULT },
+					{ Enums::Brush::MASKED_BLEND, Enums::RenderFeatures::DEFAULT }
+				};
+
+				for (const std::pair<Enums::Brush, Enums::RenderFeatures>& settings : commonSettings) {
+					if (protocols.find(settings) == protocols.end()) {
+						createProtocol(settings);
+					}
 				}
 
-				savedMetrics = metrics;
+				//everything used on previous launches, which includes any other settings that entities draw with
+				for (const auto& binary : programBinaries) {
+					if (protocols.find(binary.first) == protocols.end()) {
+						createProtocol(binary.first);
+					}
+				}
 			}
 
-			void OGL33Painter::loadSettings(const Painter::State& state) {
-				if (state == savedState) {
+			void OGL33Renderer::loadShaderCache() {
+				programBinaries.clear();
+				shaderCacheChanged = false;
+
+				os::MappedFile file;
+				try {
+					file.init(shaderCachePath);
+				} catch (const FileNotFoundError&) {
+					//first launch, so there is nothing to load
+					return;
+				} catch (const BadFileError&) {
 					return;
 				}
 
-				painterData.bind();
+				const Byte* data = file.getData();
+				const Byte* end = data + file.getSize();
 
-				if (state.transformation != savedState.transformation) {
-					painterData.setDataRange(0, sizeof(float) * 3, state.transformation.translation.begin());
-					painterData.setDataRange(sizeof(float) * 4, sizeof(float) * 3, state.transformation.rotation.begin());
-					painterData.setDataRange(sizeof(float) * 8, sizeof(float) * 3, state.transformation.scaler.begin());
-				}
-				if (state.data != savedState.data) {
-					painterData.setDataRange(sizeof(float) * 12, sizeof(float) * 4, state.data.begin());
-				}
-				if (state.foregroundColor != savedState.foregroundColor) {
-					painterData.setDataRange(sizeof(float) * 16, sizeof(float) * 4, state.foregroundColor.begin());
-				}
-				if (state.foregroundTransform != savedState.foregroundTransform) {
-					painterData.setDataRange(sizeof(float) * 20, sizeof(float) * 4, state.foregroundTransform.begin());
+				std::uint32_t magic = 0, version = 0, count = 0;
+				std::uint64_t driver = 0;
+				if (!readValue(data, end, magic) || !readValue(data, end, version) || !readValue(data, end, driver) || !readValue(data, end, count)) {
+					return;
 				}
-				if (state.backgroundColor != savedState.backgroundColor) {
-					painterData.setDataRange(sizeof(float) * 24, sizeof(float) * 4, state.backgroundColor.begin());
+
+				//binaries from another driver would be rejected anyways
+				const std::string driverName = getDriverName();
+				if (magic != MACE__SHADER_CACHE_MAGIC || version != MACE__SHADER_CACHE_VERSION
+					|| driver != hashSources(MACE__FNV_OFFSET_BASIS, { driverName.c_str() })) {
+					return;
 				}
-				if (state.backgroundTransform != savedState.backgroundTransform) {
-					painterData.setDataRange(sizeof(float) * 28, sizeof(float) * 4, state.backgroundTransform.begin());
+
+				//every feature a program can be compiled with. the renderer strips FULLY_OPAQUE before choosing a program
+				MACE_CONSTEXPR const Byte programFeatures = static_cast<Byte>(Enums::RenderFeatures::DISCARD_INVISIBLE | Enums::RenderFeatures::FILTER
+					| Enums::RenderFeatures::TEXTURE | Enums::RenderFeatures::TEXTURE_TRANSFORM | Enums::RenderFeatures::INSTANCED | Enums::RenderFeatures::BATCHED);
+
+				for (Index i = 0; i < count; ++i) {
+					Byte brush = 0, features = 0;
+					ProgramBinary binary = ProgramBinary();
+					std::uint32_t format = 0, length = 0;
+					if (!readValue(data, end, brush) || !readValue(data, end, features) || !readValue(data, end, binary.sourceHash)
+						|| !readValue(data, end, format) || !readValue(data, end, length) || static_cast<Size>(end - data) < length) {
+						return;
+					}
+
+					binary.format = static_cast<Enum>(format);
+					binary.data.assign(data, data + length);
+					data += length;
+
+					//every entry is compiled when the renderer is initialized, and an unknown brush has no shader source.
+					//if dropping unknown features changes the settings, the source hash won't match and it is recompiled
+					if (brush > static_cast<Byte>(Enums::Brush::MASKED_BLEND)) {
+						continue;
+					}
+
+					programBinaries[{ static_cast<Enums::Brush>(brush), static_cast<Enums::RenderFeatures>(features & programFeatures) }] = std::move(binary);
 				}
-				if (state.maskColor != savedState.maskColor) {
-					painterData.setDataRange(sizeof(float) * 32, sizeof(float) * 4, state.maskColor.begin());
+			}
+
+			void OGL33Renderer::saveShaderCache() {
+				if (shaderCachePath.empty() || !shaderCacheChanged) {
+					return;
 				}
-				if (state.maskTransform != savedState.maskTransform) {
-					painterData.setDataRange(sizeof(float) * 36, sizeof(float) * 4, state.maskTransform.begin());
+
+				std::ofstream out = std::ofstream(shaderCachePath, std::ios::out | std::ios::binary | std::ios::trunc);
+				//the cache only makes launching faster, so not being able to write it isn't an error
+				if (!out.is_open()) {
+					return;
 				}
 
-				if (state.filter != savedState.filter) {
-					float matrix[16];
-					state.filter.flatten(matrix);
-					painterData.setDataRange(sizeof(float) * 40, sizeof(float) * 16, std::begin(matrix));
+				const std::string driverName = getDriverName();
+
+				writeValue(out, static_cast<std::uint32_t>(MACE__SHADER_CACHE_MAGIC));
+				writeValue(out, static_cast<std::uint32_t>(MACE__SHADER_CACHE_VERSION));
+				writeValue(out, hashSources(MACE__FNV_OFFSET_BASIS, { driverName.c_str() }));
+				writeValue(out, static_cast<std::uint32_t>(programBinaries.size()));
+
+				for (const auto& binary : programBinaries) {
+					writeValue(out, static_cast<Byte>(binary.first.first));
+					writeValue(out, static_cast<Byte>(binary.first.second));
+					writeValue(out, binary.second.sourceHash);
+					writeValue(out, static_cast<std::uint32_t>(binary.second.format));
+					writeValue(out, static_cast<std::uint32_t>(binary.second.data.size()));
+					if (!binary.second.data.empty()) {
+						out.write(reinterpret_cast<const char*>(binary.second.data.data()), static_cast<std::streamsize>(binary.second.data.size()));
+					}
 				}
 
-				savedState = state;
+				shaderCacheChanged = false;
 			}
 
-			void OGL33Painter::draw(const Model& m, const Enums::Brush brush, const Enums::RenderFeatures feat) {
-				renderer->bindProtocol(this, { brush, feat });
+			void OGL33Renderer::createUniformBuffers() {
+				createPainterData(MACE__PAINTER_DATA_INITIAL_CAPACITY);
+				painterDataCursor = 0;
+
+				GLint alignment = 0;
+				glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+				alignment = std::max<GLint>(alignment, static_cast<GLint>(sizeof(float)));
+
+				const Size alignedSize = ((MACE__ENTITY_DATA_BUFFER_SIZE + alignment - 1) / alignment) * alignment;
+				entityDataStride = alignedSize / sizeof(float);
+
+				entityData.init();
+				entityData.bind();
+				entityData.setLocation(MACE__ENTITY_DATA_LOCATION);
+
+				ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Failed to create uniform buffers");
+			}
+
+			void OGL33Renderer::destroyUniformBuffers() {
+				destroyPainterData();
+
+				entityData.destroy();
+
+				entityDataStorage.clear();
+				dirtyEntities.clear();
+				dirtyEntityCount = 0;
+				entityDataCapacity = 0;
+				boundEntity = 0;
+			}
+
+			void OGL33Renderer::setEntityData(const EntityID id, const Matrix<float, 4>& worldMatrix) {
+				MACE_STATIC_ASSERT(sizeof(float) >= sizeof(EntityID), "This system doesn't not support the required size for EntityID");
+
+#ifdef MACE_DEBUG_INTERNAL_ERRORS
+				if (id == 0) {
+					MACE__THROW(OutOfBounds, "Internal Error: Entity data can't be set for an entity that isn't queued");
+				}
+#endif
+
+				const Index slot = id - 1;
+
+				if (slot >= dirtyEntities.size()) {
+					//grow geometrically so a lot of new entities don't each cause a reallocation
+					const Size newSize = std::max<Size>(slot + 1, dirtyEntities.size() * 2);
+					entityDataStorage.resize(newSize * entityDataStride, 0.0f);
+					dirtyEntities.resize(newSize, false);
+				}
+
+				float* data = entityDataStorage.data() + slot * entityDataStride;
+
+				worldMatrix.flatten(data);
+				//this crazy line puts a GLuint directly into a float, as GLSL expects a uint instead of a float
+				*reinterpret_cast<GLuint*>(data + 16) = static_cast<GLuint>(id);
+
+				if (!dirtyEntities[slot]) {
+					dirtyEntities[slot] = true;
+					++dirtyEntityCount;
+				}
+			}
+
+			void OGL33Renderer::uploadEntityData() {
+				if (dirtyEntityCount == 0) {
+					return;
+				}
+
+				entityData.bind();
+
+				if (dirtyEntities.size() > entityDataCapacity) {
+					//the whole buffer has to be reallocated anyways
+					entityDataCapacity = dirtyEntities.size();
+					entityData.setData(static_cast<ptrdiff_t>(sizeof(float) * entityDataStorage.size()), entityDataStorage.data(), MACE__ENTITY_DATA_USAGE);
+
+					std::fill(dirtyEntities.begin(), dirtyEntities.end(), false);
+				} else {
+					Index i = 0;
+					while (i < dirtyEntities.size()) {
+						if (!dirtyEntities[i]) {
+							++i;
+							continue;
+						}
+
+						const Index first = i;
+						while (i < dirtyEntities.size() && dirtyEntities[i]) {
+							dirtyEntities[i++] = false;
+						}
+
+						//the padding between entities is uploaded too, so the whole range is 1 call
+						const Size offset = first * entityDataStride, length = (i - first) * entityDataStride;
+						entityData.setDataRange(static_cast<ptrdiff_t>(sizeof(float) * offset), static_cast<ptrdiff_t>(sizeof(float) * length), entityDataStorage.data() + offset);
+					}
+				}
+
+				dirtyEntityCount = 0;
+				//reallocating may have changed what the bound range points to
+				boundEntity = 0;
+
+				ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Failed to upload entity data");
+			}
+
+			void OGL33Renderer::bindEntityData(const EntityID id) {
+				//an entity that changed during this frame has to be uploaded before it can be drawn
+				if (dirtyEntities[id - 1]) {
+					uploadEntityData();
+				}
+
+				if (boundEntity == id) {
+					return;
+				}
+
+				entityData.bindForRender(sizeof(float) * entityDataStride * (id - 1), MACE__ENTITY_DATA_BUFFER_SIZE);
+
+				boundEntity = id;
+			}
+
+			void OGL33Renderer::createPainterData(const Size capacity) {
+				GLint alignment = 0;
+				glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+				alignment = std::max<GLint>(alignment, static_cast<GLint>(sizeof(float)));
+
+				painterDataStride = ((MACE__PAINTER_DATA_BUFFER_SIZE + alignment - 1) / alignment) * alignment;
+				painterDataCapacity = capacity;
+				boundPainterData = std::numeric_limits<Index>::max();
+
+				const Size size = painterDataStride * painterDataCapacity * MACE__PAINTER_DATA_FRAMES;
+
+				painterData.init();
+				painterData.bind();
+
+				if (GLEW_ARB_buffer_storage) {
+					//the buffer stays mapped forever, so writing painter data is just a memcpy
+					MACE_CONSTEXPR const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+					glBufferStorage(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(size), nullptr, flags);
+					mappedPainterData = static_cast<Byte*>(painterData.mapRange(0, size, flags));
+				} else {
+					painterData.setData(static_cast<ptrdiff_t>(size), nullptr, MACE__PAINTER_DATA_USAGE);
+					mappedPainterData = nullptr;
+
+					//the states written this frame are kept here and uploaded together, and growing keeps the ones already written
+					painterDataStaging.resize(painterDataStride * painterDataCapacity);
+				}
+
+				painterData.setLocation(MACE__PAINTER_DATA_LOCATION);
+
+				ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Failed to create painter data buffer");
+			}
+
+			void OGL33Renderer::destroyPainterData() {
+				for (GLsync& fence : painterDataFences) {
+					if (fence != nullptr) {
+						glDeleteSync(fence);
+						fence = nullptr;
+					}
+				}
+
+				if (mappedPainterData != nullptr) {
+					painterData.bind();
+					painterData.unmap();
+					mappedPainterData = nullptr;
+				}
+
+				//opengl only deletes the storage once the GPU is done with it
+				painterData.destroy();
+			}
+
+			void OGL33Renderer::beginPainterDataFrame() {
+				painterDataFrame = (painterDataFrame + 1) % MACE__PAINTER_DATA_FRAMES;
+				painterDataCursor = 0;
+
+				GLsync& fence = painterDataFences[painterDataFrame];
+				if (fence != nullptr) {
+					//this only blocks if the GPU is more than MACE__PAINTER_DATA_FRAMES behind
+					GLenum result;
+					do {
+						result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+					} while (result == GL_TIMEOUT_EXPIRED);
+
+					glDeleteSync(fence);
+					fence = nullptr;
+
+					if (result == GL_WAIT_FAILED) {
+						ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Failed to wait for painter data");
+					}
+				}
+			}
+
+			void OGL33Renderer::endPainterDataFrame() {
+				GLsync& fence = painterDataFences[painterDataFrame];
+				if (fence != nullptr) {
+					glDeleteSync(fence);
+				}
+				fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			}
+
+			void OGL33Renderer::growPainterData() {
+				const ogl::UniformBuffer oldData = painterData;
+				Byte* const oldMapping = mappedPainterData;
+				const Size oldCapacity = painterDataCapacity;
+
+				//a new buffer isn't used by the GPU yet, so the fences of the old one don't matter
+				for (GLsync& fence : painterDataFences) {
+					if (fence != nullptr) {
+						glDeleteSync(fence);
+						fence = nullptr;
+					}
+				}
+
+				painterData = ogl::UniformBuffer();
+				createPainterData(oldCapacity * 2);
+
+				ogl::UniformBuffer source = oldData;
+				if (oldMapping != nullptr) {
+					//recorded draws refer to the states written this frame by their slot, so they have to be kept
+					source.copyData(painterData, static_cast<ptrdiff_t>(painterDataCursor * painterDataStride), painterDataFrame * oldCapacity * painterDataStride, painterDataFrame * painterDataCapacity * painterDataStride);
+
+					source.bind();
+					source.unmap();
+				}
+				//opengl only deletes the storage once the GPU is done with it
+				source.destroy();
+
+				ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Failed to grow painter data buffer");
+			}
+
+			Index OGL33Renderer::writePainterData(const Painter::State& state) {
+				if (painterDataCursor >= painterDataCapacity) {
+					growPainterData();
+				}
+
+				float painterDataBuffer[MACE__PAINTER_DATA_BUFFER_SIZE / sizeof(float)] = { 0 };
+
+				const TransformMatrix& transform = state.transformation;
+				math::compose(transform.translation, transform.rotation, transform.scaler).flatten(painterDataBuffer);
+				state.data.flatten(painterDataBuffer + 16);
+				state.foregroundColor.flatten(painterDataBuffer + 20);
+				state.foregroundTransform.flatten(painterDataBuffer + 24);
+				state.backgroundColor.flatten(painterDataBuffer + 28);
+				state.backgroundTransform.flatten(painterDataBuffer + 32);
+				state.maskColor.flatten(painterDataBuffer + 36);
+				state.maskTransform.flatten(painterDataBuffer + 40);
+				state.filter.flatten(painterDataBuffer + 44);
+
+				if (mappedPainterData != nullptr) {
+					const Index offset = (painterDataFrame * painterDataCapacity + painterDataCursor) * painterDataStride;
+					std::memcpy(mappedPainterData + offset, painterDataBuffer, MACE__PAINTER_DATA_BUFFER_SIZE);
+				} else {
+					std::memcpy(painterDataStaging.data() + painterDataCursor * painterDataStride, painterDataBuffer, MACE__PAINTER_DATA_BUFFER_SIZE);
+				}
+
+				return painterDataCursor++;
+			}
+
+			void OGL33Renderer::uploadPainterData() {
+				//a persistent mapping is already written, and nothing has to be uploaded if nothing was written
+				if (mappedPainterData != nullptr || painterDataCursor == 0) {
+					return;
+				}
+
+				const Index offset = painterDataFrame * painterDataCapacity * painterDataStride;
+				const Size size = painterDataCursor * painterDataStride;
+
+				painterData.bind();
+				//the fences guarantee that the GPU isn't reading this part of the buffer, so the driver doesn't have to synchronize
+				void* destination = painterData.mapRange(offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+				if (destination != nullptr) {
+					std::memcpy(destination, painterDataStaging.data(), size);
+				}
+				painterData.unmap();
+
+				ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Failed to upload painter data");
+			}
+
+			void OGL33Renderer::bindPainterData(const Index slot) {
+				const Index offset = (painterDataFrame * painterDataCapacity + slot) * painterDataStride;
+
+				if (offset != boundPainterData) {
+					painterData.bindForRender(offset, MACE__PAINTER_DATA_BUFFER_SIZE);
+
+					boundPainterData = offset;
+				}
+			}
+
+			void OGL33Renderer::createBatchBuffers() {
+				batchInstances.reserve(MACE__BATCH_MAXIMUM_QUADS);
+
+				batchArray.init();
+				batchArray.bind();
+
+				//same as Model::getQuad(), interleaved as position and then texture coordinate
+				MACE_CONSTEXPR const float quadVertices[] = {
+					-1.0f, -1.0f, 0.0f, 0.0f, 1.0f,
+					-1.0f, 1.0f, 0.0f, 0.0f, 0.0f,
+					1.0f, 1.0f, 0.0f, 1.0f, 0.0f,
+					1.0f, -1.0f, 0.0f, 1.0f, 1.0f
+				};
+				MACE_CONSTEXPR const unsigned int quadIndices[] = {
+					0, 1, 3,
+					1, 2, 3
+				};
+
+				batchVertices.init();
+				batchVertices.bind();
+				batchVertices.setData(sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
+
+				batchVertices.setLocation(MACE__VAO_DEFAULT_VERTICES_LOCATION);
+				batchVertices.setAttributePointer(3, GL_FLOAT, false, sizeof(float) * 5, nullptr);
+				batchVertices.enable();
+
+				batchVertices.setLocation(MACE__VAO_DEFAULT_TEXTURE_COORD_LOCATION);
+				batchVertices.setAttributePointer(2, GL_FLOAT, false, sizeof(float) * 5, reinterpret_cast<const void*>(sizeof(float) * 3));
+				batchVertices.enable();
+
+				batchIndices = ogl::ElementBuffer(6);
+				batchIndices.init();
+				batchIndices.bind();
+				batchIndices.setData(sizeof(quadIndices), quadIndices, GL_STATIC_DRAW);
+
+				batchInstanceBuffer.init();
+				batchInstanceBuffer.bind();
+				batchInstanceBuffer.setData(static_cast<ptrdiff_t>(sizeof(QuadInstance) * MACE__BATCH_MAXIMUM_QUADS), nullptr, GL_STREAM_DRAW);
+
+				struct Attribute {
+					Index location;
+					Byte size;
+					Enum type;
+					Size offset;
+				};
+
+				const Attribute attributes[] = {
+					{ MACE__VAO_BATCH_MATRIX_LOCATION, 4, GL_FLOAT, offsetof(QuadInstance, matrix) },
+					{ MACE__VAO_BATCH_MATRIX_LOCATION + 1, 4, GL_FLOAT, offsetof(QuadInstance, matrix) + sizeof(float) * 4 },
+					{ MACE__VAO_BATCH_MATRIX_LOCATION + 2, 4, GL_FLOAT, offsetof(QuadInstance, matrix) + sizeof(float) * 8 },
+					{ MACE__VAO_BATCH_MATRIX_LOCATION + 3, 4, GL_FLOAT, offsetof(QuadInstance, matrix) + sizeof(float) * 12 },
+					{ MACE__VAO_BATCH_FOREGROUND_COLOR_LOCATION, 4, GL_FLOAT, offsetof(QuadInstance, foregroundColor) },
+					{ MACE__VAO_BATCH_FOREGROUND_TRANSFORM_LOCATION, 4, GL_FLOAT, offsetof(QuadInstance, foregroundTransform) },
+					{ MACE__VAO_BATCH_MASK_COLOR_LOCATION, 4, GL_FLOAT, offsetof(QuadInstance, maskColor) },
+					{ MACE__VAO_BATCH_MASK_TRANSFORM_LOCATION, 4, GL_FLOAT, offsetof(QuadInstance, maskTransform) },
+					{ MACE__VAO_BATCH_ENTITY_ID_LOCATION, 1, GL_UNSIGNED_INT, offsetof(QuadInstance, entityID) },
+					{ MACE__VAO_BATCH_DEPTH_LOCATION, 1, GL_FLOAT, offsetof(QuadInstance, depth) },
+				};
+
+				for (const Attribute& attrib : attributes) {
+					batchInstanceBuffer.setLocation(attrib.location);
+					batchInstanceBuffer.setAttributePointer(attrib.size, attrib.type, false, sizeof(QuadInstance), reinterpret_cast<const void*>(attrib.offset));
+					batchInstanceBuffer.setDivisor(1);
+					batchInstanceBuffer.enable();
+				}
+
+				batchArray.unbind();
+
+				ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Failed to create buffers for batching");
+			}
+
+			void OGL33Renderer::destroyBatchBuffers() {
+				batchInstances.clear();
+
+				batchArray.destroy();
+				batchVertices.destroy();
+				batchIndices.destroy();
+				batchInstanceBuffer.destroy();
+
+				batchKey = BatchKey();
+				quad = Model();
+			}
+
+			bool OGL33Renderer::canBatch(const Model& m, const Enums::Brush brush) {
+				//blending brushes read mc_Data and the background, which are not part of a batch
+				if (brush != Enums::Brush::TEXTURE && brush != Enums::Brush::COLOR && brush != Enums::Brush::MASK) {
+					return false;
+				}
+
+				if (!quad.isCreated()) {
+					quad = Model::getQuad();
+				}
+
+				return m == quad;
+			}
+
+			void OGL33Renderer::recordDraw(OGL33Painter* painter, const Model& m, const Enums::Brush brush, const Enums::RenderFeatures feat, const InstanceData* instances, const Size count) {
+				const Painter::State& state = *painter->currentState;
+
+				DrawCommand command;
+				command.brush = brush;
+				command.entity = painter->painter->getID();
+				command.filter = state.filter;
+
+				//nothing behind an opaque draw can show through it, so it never has to discard
+				command.opaque = isOpaque(brush, feat, state, instances);
+				command.features = command.opaque ? feat & ~(Enums::RenderFeatures::FULLY_OPAQUE | Enums::RenderFeatures::DISCARD_INVISIBLE) : feat & ~Enums::RenderFeatures::FULLY_OPAQUE;
+
+				for (Index i = 0; i < command.textures.size(); ++i) {
+					if (usesTexture(brush, static_cast<Enums::TextureSlot>(i))) {
+						command.textures[i] = painter->textures[i];
+					}
+				}
+
+				CommandList& list = recordingList != nullptr ? *recordingList : *commandLists[currentList];
+
+				//anything that isn't a quad could be anywhere on the screen
+				MACE_CONSTEXPR const float infinity = std::numeric_limits<float>::infinity();
+				command.bounds = { -infinity, -infinity, infinity, infinity };
+
+				if (instances == nullptr && canBatch(m, brush)) {
+					command.batched = true;
+					command.quad = list.quads.size();
+
+					list.quads.push_back(createQuadInstance(painter, state));
+					command.bounds = getQuadBounds(list.quads.back());
+				} else {
+					command.model = m;
+
+					//the painter data is written when the lists are merged, as it needs opengl
+					if (painter->changedFields != 0 || painter->stateFrame != frameNumber || painter->stateList != list.index) {
+						list.states.push_back(state);
+
+						painter->changedFields = 0;
+						painter->stateFrame = frameNumber;
+						painter->stateList = list.index;
+						painter->stateSlot = list.states.size() - 1;
+					}
+					command.painterDataSlot = painter->stateSlot;
+
+					if (instances != nullptr) {
+						//the painter only has to keep the instances alive until the end of the draw call
+						command.instanceOffset = list.instances.size();
+						command.instanceCount = count;
+						list.instances.insert(list.instances.end(), instances, instances + count);
+					}
+				}
+
+				if (recordingList != nullptr) {
+					command.target = list.target;
+					combineBounds(list.bounds, command.bounds);
+				} else {
+					command.target = cacheStack.empty() ? 0 : cacheStack.back();
+					if (command.target != 0) {
+						combineBounds(cacheTargets[command.target - 1].bounds, command.bounds);
+					}
+				}
+
+				list.commands.push_back(command);
+			}
+
+			void OGL33Renderer::recordCache(const RenderCache& cache) {
+				//nothing in the subtree was visible
+				if (cache.width == 0 || cache.height == 0) {
+					return;
+				}
+
+				const DrawBounds bounds = {
+					static_cast<float>(cache.x) / static_cast<float>(sceneWidth) * 2.0f - 1.0f,
+					static_cast<float>(cache.y) / static_cast<float>(sceneHeight) * 2.0f - 1.0f,
+					static_cast<float>(cache.x + cache.width) / static_cast<float>(sceneWidth) * 2.0f - 1.0f,
+					static_cast<float>(cache.y + cache.height) / static_cast<float>(sceneHeight) * 2.0f - 1.0f
+				};
+
+				DrawCommand command;
+				command.brush = Enums::Brush::TEXTURE;
+				command.features = Enums::RenderFeatures::DEFAULT;
+				command.cache = &cache;
+				command.bounds = bounds;
+
+				command.target = cacheStack.empty() ? 0 : cacheStack.back();
+				if (command.target != 0) {
+					combineBounds(cacheTargets[command.target - 1].bounds, bounds);
+				}
+
+				commandLists[currentList]->commands.push_back(command);
+			}
+
+			Index OGL33Renderer::beginCommandList() {
+				if (usedCommandLists == commandLists.size()) {
+					commandLists.push_back(std::unique_ptr<CommandList>(new CommandList()));
+				}
+
+				CommandList& list = *commandLists[usedCommandLists];
+				list.index = usedCommandLists;
+				list.commands.clear();
+				list.quads.clear();
+				list.instances.clear();
+				list.states.clear();
+
+				MACE_CONSTEXPR const float infinity = std::numeric_limits<float>::infinity();
+				list.target = 0;
+				list.bounds = { infinity, infinity, -infinity, -infinity };
+				list.error = nullptr;
+
+				return usedCommandLists++;
+			}
+
+			void OGL33Renderer::waitForRecordings() {
+				if (queuedRecordings == 0) {
+					return;
+				}
+
+				{
+					std::unique_lock<std::mutex> guard(recordingMutex);
+					recordingFinish.wait(guard, [this] () {
+						return unfinishedRecordings == 0;
+					});
+				}
+				queuedRecordings = 0;
+
+				for (Index i = 0; i < usedCommandLists; ++i) {
+					CommandList& list = *commandLists[i];
+
+					//the rendering thread already added the bounds of it's own lists
+					if (list.target != 0 && !list.commands.empty()) {
+						combineBounds(cacheTargets[list.target - 1].bounds, list.bounds);
+						list.target = 0;
+					}
+				}
+			}
+
+			void OGL33Renderer::mergeCommandLists() {
+				MACE_CONSTEXPR const float infinity = std::numeric_limits<float>::infinity();
+
+				Size totalCommands = 0;
+				//the IDs of a cache are copied over the scene regardless of depth, so a draw over it has to be drawn after it
+				DrawBounds cachedBounds = { infinity, infinity, -infinity, -infinity };
+				for (Index i = 0; i < usedCommandLists; ++i) {
+					totalCommands += commandLists[i]->commands.size();
+
+					if (picking && offscreen) {
+						for (const DrawCommand& command : commandLists[i]->commands) {
+							if (command.cache != nullptr && command.target == 0) {
+								combineBounds(cachedBounds, command.bounds);
+							}
+						}
+					}
+				}
+
+				//caches are drawn with the default state, and batched shaders only read the filter from theirs
+				defaultPainterDataSlot = writePainterData(Painter::State());
+				Matrix<float, 4, 4> batchFilter = Painter::State().filter;
+				Index batchPainterDataSlot = defaultPainterDataSlot;
+
+				Index commandNumber = 0;
+				for (Index i = 0; i < usedCommandLists; ++i) {
+					CommandList& list = *commandLists[i];
+
+					const Index quadOffset = batchedQuads.size();
+					const Index instanceOffset = frameInstances.size();
+
+					batchedQuads.insert(batchedQuads.end(), list.quads.begin(), list.quads.end());
+					frameInstances.insert(frameInstances.end(), list.instances.begin(), list.instances.end());
+
+					//every state in a list was recorded because it changed, so each is written once
+					mergedStates.clear();
+					for (const Painter::State& state : list.states) {
+						mergedStates.push_back(writePainterData(state));
+					}
+
+					for (DrawCommand& command : list.commands) {
+						//draws are merged in the order they were recorded, so a draw is always layered over the draws before it
+						++commandNumber;
+						command.depth = 1.0f - 2.0f * static_cast<float>(commandNumber) / static_cast<float>(totalCommands + 1);
+
+						const DrawBounds& bounds = command.bounds;
+						command.opaque = command.opaque && command.target == 0
+							&& !(bounds.left <= cachedBounds.right && cachedBounds.left <= bounds.right && bounds.bottom <= cachedBounds.top && cachedBounds.bottom <= bounds.top);
+
+						std::uint64_t layerKey;
+						if (command.opaque) {
+							layerKey = static_cast<std::uint64_t>(0x7FFFFFFF - getLayer(command.bounds, opaqueLayerBounds)) << 32;
+						} else {
+							layerKey = (static_cast<std::uint64_t>(1) << 63) | (static_cast<std::uint64_t>(getLayer(command.bounds, layerBounds)) << 32);
+						}
+
+						if (command.cache != nullptr) {
+							command.key = layerKey;
+							commands.push_back(std::move(command));
+							continue;
+						}
+
+						if (command.batched) {
+							command.quad += quadOffset;
+							batchedQuads[command.quad].depth = command.depth;
+
+							//quads drawn one after another usually share a filter, so they share a slot as well
+							if (command.filter != batchFilter) {
+								Painter::State batchState = Painter::State();
+								batchState.filter = command.filter;
+								batchPainterDataSlot = writePainterData(batchState);
+								batchFilter = command.filter;
+							}
+							command.painterDataSlot = batchPainterDataSlot;
+						} else {
+							command.painterDataSlot = mergedStates[command.painterDataSlot];
+							command.instanceOffset += instanceOffset;
+						}
+
+						const Enums::RenderFeatures programFeatures = command.batched ? command.features | Enums::RenderFeatures::BATCHED : command.features;
+						const std::uint64_t programKey = (static_cast<std::uint64_t>(command.brush) << 8) | static_cast<std::uint64_t>(programFeatures);
+
+						std::array<const void*, 3> textureSet;
+						for (Index j = 0; j < textureSet.size(); ++j) {
+							textureSet[j] = command.textures[j].isCreated() ? command.textures[j].getImpl().get() : nullptr;
+						}
+						const std::uint64_t textureKey = std::min<std::uint64_t>(textureSets.insert({ textureSet, textureSets.size() }).first->second, 0xFFFF);
+
+						command.key = layerKey | (programKey << 16) | textureKey;
+
+						commands.push_back(std::move(command));
+					}
+
+					list.commands.clear();
+					list.quads.clear();
+					list.instances.clear();
+					list.states.clear();
+				}
+
+				usedCommandLists = 0;
+
+				//every state of the frame was written above
+				uploadPainterData();
+			}
+
+			Index OGL33Renderer::getLayer(const DrawBounds& bounds, std::vector<DrawBounds>& layers) {
+				//a draw has to be drawn after every draw it overlaps, as blending depends on the order. checking the
+				//combined bounds of each layer instead of every draw is conservative, but much faster
+				Index layer = 0;
+				for (Index i = layers.size(); i > 0; --i) {
+					const DrawBounds& other = layers[i - 1];
+					if (bounds.left <= other.right && other.left <= bounds.right && bounds.bottom <= other.top && other.bottom <= bounds.top) {
+						layer = i;
+						break;
+					}
+				}
+
+				if (layer == layers.size()) {
+					layers.push_back(bounds);
+				} else {
+					combineBounds(layers[layer], bounds);
+				}
+
+				return layer;
+			}
+
+			OGL33Renderer::QuadInstance OGL33Renderer::createQuadInstance(const OGL33Painter* painter, const Painter::State& state) const {
+				const TransformMatrix& transform = state.transformation;
+
+				//an unbatched draw multiplies both matrices in the shader, but a quad only has 4 vertices so it's done once here
+				QuadInstance instance;
+				math::multiply(math::compose(transform.translation, transform.rotation, transform.scaler), painter->savedWorldMatrix).flatten(instance.matrix);
+				state.foregroundColor.flatten(instance.foregroundColor);
+				state.foregroundTransform.flatten(instance.foregroundTransform);
+				state.maskColor.flatten(instance.maskColor);
+				state.maskTransform.flatten(instance.maskTransform);
+				instance.entityID = static_cast<GLuint>(painter->painter->getID());
+				//set once the command lists are merged
+				instance.depth = 0.0f;
+
+				return instance;
+			}
+
+			OGL33Renderer::DrawBounds OGL33Renderer::getQuadBounds(const QuadInstance& instance) const {
+				MACE_CONSTEXPR const float corners[4][2] = {
+					{ -1.0f, -1.0f },
+					{ -1.0f, 1.0f },
+					{ 1.0f, 1.0f },
+					{ 1.0f, -1.0f }
+				};
+
+				MACE_CONSTEXPR const float infinity = std::numeric_limits<float>::infinity();
+				DrawBounds bounds = { infinity, infinity, -infinity, -infinity };
+
+				const float* m = instance.matrix;
+				for (Index i = 0; i < 4; ++i) {
+					//same as the vertex shader. the quad is flat, so the Z coordinate is skipped
+					const float x = corners[i][0] * m[0] + corners[i][1] * m[4] + m[12];
+					const float y = corners[i][0] * m[1] + corners[i][1] * m[5] + m[13];
+
+					bounds.left = std::min(bounds.left, x);
+					bounds.bottom = std::min(bounds.bottom, y);
+					bounds.right = std::max(bounds.right, x);
+					bounds.top = std::max(bounds.top, y);
+				}
+
+				return bounds;
+			}
+
+			void OGL33Renderer::submitCommands() {
+				mergeCommandLists();
+
+				if (commands.empty()) {
+					return;
+				}
+
+				//entities that changed while their draws were being recorded
+				uploadEntityData();
+
+				//anything could have been bound while recording, like a texture being created
+				boundProtocol = nullptr;
+				boundTextures.fill(nullptr);
+
+				sortedCommands.clear();
+				sortedCommands.reserve(commands.size());
+				for (Index i = 0; i < commands.size(); ++i) {
+					sortedCommands.push_back({ commands[i].key, i });
+				}
+
+				radixSort(sortedCommands, sortScratch);
+
+				if (!cacheTargets.empty()) {
+					//a cache has to be rendered before it is drawn. caches inside other caches are always recorded after them,
+					//so drawing the targets from last to first renders every cache before the target it's drawn into
+					std::stable_sort(sortedCommands.begin(), sortedCommands.end(), [this] (const std::pair<std::uint64_t, Index>& left, const std::pair<std::uint64_t, Index>& right) {
+						return commands[left.second].target > commands[right.second].target;
+					});
+				}
+
+				for (const std::pair<std::uint64_t, Index>& entry : sortedCommands) {
+					const DrawCommand& command = commands[entry.second];
+
+					if (command.target != boundTarget) {
+						flushBatch();
+						bindTarget(command.target);
+					}
+
+					if (command.opaque != opaquePass) {
+						flushBatch();
+						bindPass(command.opaque);
+					}
+
+					if (command.opaque) {
+						++frameStatistics.opaqueDraws;
+					}
+
+					if (command.cache != nullptr) {
+						flushBatch();
+						drawCache(*command.cache, command.depth);
+						continue;
+					}
+
+					if (command.batched) {
+						batchQuad(command);
+						continue;
+					}
+
+					flushBatch();
+
+					bindProtocol({ command.brush, command.features });
+					glUniform1f(boundProtocol->depthLocation, command.depth);
+					bindPainterData(command.painterDataSlot);
+					bindEntityData(command.entity);
+					bindTextures(command.brush, command.textures);
+
+					//the state cache skips this if the model is already bound
+					command.model.bind();
+
+					if ((command.features & Enums::RenderFeatures::INSTANCED) != Enums::RenderFeatures::NONE) {
+						bindInstances(frameInstances.data() + command.instanceOffset, command.instanceCount);
+						command.model.drawInstanced(command.instanceCount);
+						unbindInstances();
+					} else {
+						command.model.draw();
+					}
+
+					++frameStatistics.drawCalls;
+				}
+
+				flushBatch();
+
+				if (boundTarget != 0) {
+					bindTarget(0);
+				}
+
+				if (opaquePass) {
+					bindPass(false);
+				}
+
+				commands.clear();
+				batchedQuads.clear();
+				frameInstances.clear();
+				layerBounds.clear();
+				opaqueLayerBounds.clear();
+				textureSets.clear();
+			}
+
+			void OGL33Renderer::bindTarget(const Index target) {
+				Enum drawBuffers[2];
+				drawBuffers[MACE__SCENE_ATTACHMENT_INDEX] = GL_COLOR_ATTACHMENT0 + MACE__SCENE_ATTACHMENT_INDEX;
+				drawBuffers[MACE__ID_ATTACHMENT_INDEX] = GL_COLOR_ATTACHMENT0 + MACE__ID_ATTACHMENT_INDEX;
+
+				if (target == 0) {
+					if (offscreen) {
+						frameBuffer.bind();
+						frameBuffer.setDrawBuffers(2, drawBuffers);
+					} else {
+						frameBuffer.unbind();
+						ogl::FrameBuffer::setDrawBuffer(GL_BACK);
+					}
+
+					ogl::setViewport(0, 0, sceneWidth, sceneHeight);
+					ogl::setBlending(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+				} else {
+					RenderCache& cache = *cacheTargets[target - 1].cache;
+
+					cache.frameBuffer.bind();
+					cache.frameBuffer.setDrawBuffers(2, drawBuffers);
+					ogl::FrameBuffer::setClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+					ogl::FrameBuffer::clear(GL_COLOR_BUFFER_BIT);
+
+					//the viewport covers the whole scene, offset so the part the cache covers lands in it's textures
+					glViewport(-cache.x, -cache.y, sceneWidth, sceneHeight);
+
+					//the cache stores premultiplied alpha, so drawing it looks the same as drawing the subtree directly
+					ogl::setBlending(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+				}
+
+				boundTarget = target;
+
+				ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Failed to bind draw target");
+			}
+
+			void OGL33Renderer::bindPass(const bool opaque) {
+				//nothing can show through an opaque draw, so blending it would only cost bandwidth
+				if (opaque) {
+					ogl::disable(GL_BLEND);
+					glDepthMask(GL_TRUE);
+				} else {
+					ogl::enable(GL_BLEND);
+					glDepthMask(GL_FALSE);
+				}
+
+				opaquePass = opaque;
+
+				ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Failed to bind render pass");
+			}
+
+			void OGL33Renderer::drawCache(const RenderCache& cache, const float depth) {
+				bindProtocol({ Enums::Brush::TEXTURE, Enums::RenderFeatures::DEFAULT | Enums::RenderFeatures::BATCHED });
+
+				//batched shaders only read the filter, which is the identity by default
+				bindPainterData(defaultPainterDataSlot);
+
+				cache.colorTexture.bind(static_cast<unsigned int>(Enums::TextureSlot::FOREGROUND));
+				boundTextures[static_cast<Index>(Enums::TextureSlot::FOREGROUND)] = &cache.colorTexture;
+
+				//a quad covering the cache, with the texture flipped as framebuffers are stored bottom to top
+				QuadInstance instance = QuadInstance();
+				instance.matrix[0] = static_cast<float>(cache.width) / static_cast<float>(sceneWidth);
+				instance.matrix[5] = static_cast<float>(cache.height) / static_cast<float>(sceneHeight);
+				instance.matrix[10] = 1.0f;
+				instance.matrix[12] = (static_cast<float>(cache.x) + static_cast<float>(cache.width) * 0.5f) / static_cast<float>(sceneWidth) * 2.0f - 1.0f;
+				instance.matrix[13] = (static_cast<float>(cache.y) + static_cast<float>(cache.height) * 0.5f) / static_cast<float>(sceneHeight) * 2.0f - 1.0f;
+				instance.matrix[15] = 1.0f;
+				instance.foregroundTransform[1] = 1.0f;
+				instance.foregroundTransform[2] = -1.0f;
+				instance.foregroundTransform[3] = 1.0f;
+				instance.maskTransform[2] = 1.0f;
+				instance.maskTransform[3] = 1.0f;
+				instance.depth = depth;
+
+				ogl::setBlending(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+				batchArray.bind();
+
+				batchInstanceBuffer.bind();
+				batchInstanceBuffer.setData(static_cast<ptrdiff_t>(sizeof(QuadInstance) * MACE__BATCH_MAXIMUM_QUADS), nullptr, GL_STREAM_DRAW);
+				batchInstanceBuffer.setDataRange(0, static_cast<ptrdiff_t>(sizeof(QuadInstance)), &instance);
+
+				glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr, 1);
+
+				++frameStatistics.drawCalls;
+
+				if (boundTarget == 0) {
+					ogl::setBlending(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+				} else {
+					ogl::setBlending(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+				}
+
+				//the quad wrote 0 as the ID of every pixel, so the IDs the subtree drew are copied over it
+				if (picking && (boundTarget != 0 || offscreen)) {
+					ogl::FrameBuffer& destination = boundTarget == 0 ? frameBuffer : cacheTargets[boundTarget - 1].cache->frameBuffer;
+					const int x = boundTarget == 0 ? cache.x : cache.x - cacheTargets[boundTarget - 1].cache->x;
+					const int y = boundTarget == 0 ? cache.y : cache.y - cacheTargets[boundTarget - 1].cache->y;
+
+					Enum idBuffers[2];
+					idBuffers[MACE__SCENE_ATTACHMENT_INDEX] = GL_NONE;
+					idBuffers[MACE__ID_ATTACHMENT_INDEX] = GL_COLOR_ATTACHMENT0 + MACE__ID_ATTACHMENT_INDEX;
+
+					glBindFramebuffer(GL_READ_FRAMEBUFFER, cache.frameBuffer.getID());
+					ogl::FrameBuffer::setReadBuffer(GL_COLOR_ATTACHMENT0 + MACE__ID_ATTACHMENT_INDEX);
+					destination.setDrawBuffers(2, idBuffers);
+
+					glBlitFramebuffer(0, 0, cache.width, cache.height, x, y, x + cache.width, y + cache.height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+					idBuffers[MACE__SCENE_ATTACHMENT_INDEX] = GL_COLOR_ATTACHMENT0 + MACE__SCENE_ATTACHMENT_INDEX;
+					destination.setDrawBuffers(2, idBuffers);
+					glBindFramebuffer(GL_READ_FRAMEBUFFER, destination.getID());
+				}
+
+				ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Failed to draw render cache");
+			}
+
+			bool OGL33Renderer::onBeginCache(Entity* en, const Index id, const bool stale) {
+				RenderCache& cache = renderCaches[id];
+				cache.lastUsed = frameNumber;
+
+				const Entity::Metrics metrics = en->getMetrics();
+				if (cache.valid && !stale && cache.metrics == metrics && cache.sceneWidth == sceneWidth && cache.sceneHeight == sceneHeight) {
+					recordCache(cache);
+
+					++frameStatistics.cacheHits;
+					return false;
+				}
+
+				cache.valid = false;
+				cache.metrics = metrics;
+				cache.sceneWidth = sceneWidth;
+				cache.sceneHeight = sceneHeight;
+
+				MACE_CONSTEXPR const float infinity = std::numeric_limits<float>::infinity();
+				cacheTargets.push_back({ &cache, { infinity, infinity, -infinity, -infinity } });
+				cacheStack.push_back(cacheTargets.size());
+
+				++frameStatistics.cacheMisses;
+				return true;
+			}
+
+			void OGL33Renderer::onEndCache(Entity*, const Index id) {
+				//subtrees recorded on other threads may have drawn into the cache, so it's bounds aren't known until they are done
+				waitForRecordings();
+
+				const auto found = renderCaches.find(id);
+				//if the cache was drawn instead, nothing was pushed
+				if (cacheStack.empty() || found == renderCaches.end() || cacheTargets[cacheStack.back() - 1].cache != &found->second) {
+					return;
+				}
+
+				const Index target = cacheStack.back();
+				cacheStack.pop_back();
+				const Index parent = cacheStack.empty() ? 0 : cacheStack.back();
+
+				RenderCache& cache = found->second;
+				const DrawBounds bounds = cacheTargets[target - 1].bounds;
+
+				//the pixels of the scene that the subtree drew to. bounds can be infinite, or empty if nothing was drawn
+				const auto toPixels = [] (const float ndc, const int size) {
+					return (std::min(std::max(ndc, -1.0f), 1.0f) + 1.0f) * 0.5f * static_cast<float>(size);
+				};
+				const int left = static_cast<int>(std::floor(toPixels(bounds.left, sceneWidth)));
+				const int bottom = static_cast<int>(std::floor(toPixels(bounds.bottom, sceneHeight)));
+				const int right = static_cast<int>(std::ceil(toPixels(bounds.right, sceneWidth)));
+				const int top = static_cast<int>(std::ceil(toPixels(bounds.top, sceneHeight)));
+
+				const bool visible = right > left && top > bottom;
+				if (!visible || !allocateCache(cache, right - left, top - bottom)) {
+					//the subtree is drawn straight into the parent instead
+					for (Index i = 0; i < usedCommandLists; ++i) {
+						for (DrawCommand& command : commandLists[i]->commands) {
+							if (command.target == target) {
+								command.target = parent;
+							}
+						}
+					}
+
+					if (parent != 0) {
+						combineBounds(cacheTargets[parent - 1].bounds, bounds);
+					}
+
+					//if nothing was visible, the cache is still valid. drawing it just draws nothing
+					if (!visible) {
+						destroyCache(cache);
+						cache.valid = true;
+					}
+
+					return;
+				}
+
+				cache.x = left;
+				cache.y = bottom;
+				cache.valid = true;
+
+				recordCache(cache);
+			}
+
+			void OGL33Renderer::onRecordParallel(Entity* en) {
+				//the rendering thread takes a core as well
+				while (recordingWorkers.size() + 1 < std::max<Size>(std::thread::hardware_concurrency(), 1)) {
+					recordingWorkers.emplace_back(&OGL33Renderer::runRecordingWorker, this);
+				}
+
+				{
+					const std::unique_lock<std::mutex> guard(recordingMutex);
+					//every worker already has a subtree to record
+					if (unfinishedRecordings >= recordingWorkers.size()) {
+						Renderer::onRecordParallel(en);
+						return;
+					}
+				}
+
+				//resources are created the first time they are used, which can't happen without a context
+				if (!quad.isCreated()) {
+					quad = Model::getQuad();
+				}
+				Texture::getSolidColor();
+				Texture::getGradient();
+
+				CommandList& list = *commandLists[beginCommandList()];
+				list.target = cacheStack.empty() ? 0 : cacheStack.back();
+
+				//draws recorded after the subtree have to stay after it
+				currentList = beginCommandList();
+
+				{
+					const std::unique_lock<std::mutex> guard(recordingMutex);
+					pendingRecordings.push_back({ en, &list, context->getWindow() });
+					++unfinishedRecordings;
+				}
+				recordingStart.notify_one();
+
+				++queuedRecordings;
+				++frameStatistics.parallelRecordings;
+			}
+
+			void OGL33Renderer::runRecordingWorker() {
+				std::unique_lock<std::mutex> guard(recordingMutex);
+
+				while (true) {
+					recordingStart.wait(guard, [this] () {
+						return stoppingRecording || !pendingRecordings.empty();
+					});
+
+					if (stoppingRecording) {
+						return;
+					}
+
+					const PendingRecording recording = pendingRecordings.front();
+					pendingRecordings.pop_front();
+
+					guard.unlock();
+
+					setRecordingWindow(recording.window);
+					recordingList = recording.list;
+
+					try {
+						Renderer::record(recording.entity);
+					} catch (...) {
+						recording.list->error = std::current_exception();
+					}
+
+					recordingList = nullptr;
+					setRecordingWindow(nullptr);
+
+					guard.lock();
+
+					if (--unfinishedRecordings == 0) {
+						recordingFinish.notify_one();
+					}
+				}
+			}
+
+			void OGL33Renderer::stopRecordingWorkers() {
+				{
+					const std::unique_lock<std::mutex> guard(recordingMutex);
+					stoppingRecording = true;
+				}
+				recordingStart.notify_all();
+
+				for (std::thread& worker : recordingWorkers) {
+					worker.join();
+				}
+				recordingWorkers.clear();
+
+				stoppingRecording = false;
+			}
+
+			void OGL33Renderer::onFinishRecording() {
+				waitForRecordings();
+
+				for (Index i = 0; i < usedCommandLists; ++i) {
+					if (commandLists[i]->error != nullptr) {
+						std::rethrow_exception(commandLists[i]->error);
+					}
+				}
+			}
+
+			bool OGL33Renderer::allocateCache(RenderCache& cache, const int width, const int height) {
+				if (cache.colorTexture.isCreated() && cache.width == width && cache.height == height) {
+					return true;
+				}
+
+				destroyCache(cache);
+
+				const Size bytes = static_cast<Size>(width) * static_cast<Size>(height) * MACE__RENDER_CACHE_PIXEL_SIZE;
+				const Size budget = context->getWindow()->getLaunchConfig().renderCacheBudget;
+
+				while (renderCacheMemory + bytes > budget) {
+					//caches used this frame may already have been drawn, so they can't be deleted
+					auto oldest = renderCaches.end();
+					for (auto iter = renderCaches.begin(); iter != renderCaches.end(); ++iter) {
+						if (iter->second.lastUsed < frameNumber && (oldest == renderCaches.end() || iter->second.lastUsed < oldest->second.lastUsed)) {
+							oldest = iter;
+						}
+					}
+
+					if (oldest == renderCaches.end()) {
+						return false;
+					}
+
+					destroyCache(oldest->second);
+					renderCaches.erase(oldest);
+				}
+
+				cache.colorTexture.init();
+				cache.colorTexture.bind();
+				cache.colorTexture.setParameter(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+				cache.colorTexture.setParameter(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+				cache.colorTexture.setData(nullptr, width, height, GL_UNSIGNED_BYTE, GL_RGBA, GL_RGBA, 0);
+
+				cache.idTexture.init();
+				cache.idTexture.bind();
+				cache.idTexture.setParameter(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+				cache.idTexture.setParameter(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+				cache.idTexture.setData(nullptr, width, height, GL_UNSIGNED_INT, GL_RED_INTEGER, GL_R32UI, 0);
+
+				//the textures were bound to the active unit, which drawing may expect to hold something else
+				boundTextures.fill(nullptr);
+
+				cache.frameBuffer.init();
+				cache.frameBuffer.bind();
+				cache.frameBuffer.attachTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + MACE__SCENE_ATTACHMENT_INDEX, cache.colorTexture);
+				cache.frameBuffer.attachTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + MACE__ID_ATTACHMENT_INDEX, cache.idTexture);
+
+				const Enum status = cache.frameBuffer.checkStatus(GL_FRAMEBUFFER);
+
+				//caches are created while recording, when the scene is expected to be bound
+				bindTarget(0);
+
+				cache.width = width;
+				cache.height = height;
+				renderCacheMemory += bytes;
+
+				if (status != GL_FRAMEBUFFER_COMPLETE) {
+					destroyCache(cache);
+					return false;
+				}
+
+				ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Failed to create render cache");
+
+				return true;
+			}
+
+			void OGL33Renderer::destroyCache(RenderCache& cache) {
+				if (cache.colorTexture.isCreated()) {
+					cache.frameBuffer.destroy();
+					cache.colorTexture.destroy();
+					cache.idTexture.destroy();
+
+					renderCacheMemory -= static_cast<Size>(cache.width) * static_cast<Size>(cache.height) * MACE__RENDER_CACHE_PIXEL_SIZE;
+				}
+
+				cache.width = 0;
+				cache.height = 0;
+				cache.valid = false;
+			}
+
+			void OGL33Renderer::bindTextures(const Enums::Brush brush, const std::array<Texture, 3>& textures) {
+				for (Index i = 0; i < textures.size(); ++i) {
+					if (!usesTexture(brush, static_cast<Enums::TextureSlot>(i))) {
+						continue;
+					}
+
+					const void* impl = textures[i].isCreated() ? textures[i].getImpl().get() : nullptr;
+					if (impl == nullptr || impl != boundTextures[i]) {
+						textures[i].bind(static_cast<unsigned int>(i));
+						boundTextures[i] = impl;
+
+						++frameStatistics.textureBinds;
+					}
+				}
+			}
+
+			void OGL33Renderer::batchQuad(const DrawCommand& command) {
+				const Texture& foreground = command.textures[static_cast<Index>(Enums::TextureSlot::FOREGROUND)];
+				const Texture& mask = command.textures[static_cast<Index>(Enums::TextureSlot::MASK)];
+
+				if (!batchInstances.empty()) {
+					//only the actual GPU texture matters, the hue and transform are per instance
+					const bool compatible = batchKey.brush == command.brush && batchKey.features == command.features
+						&& batchKey.textures[static_cast<Index>(Enums::TextureSlot::FOREGROUND)].getImpl() == foreground.getImpl()
+						&& batchKey.textures[static_cast<Index>(Enums::TextureSlot::MASK)].getImpl() == mask.getImpl()
+						&& batchKey.filter == command.filter;
+
+					if (!compatible || batchInstances.size() >= MACE__BATCH_MAXIMUM_QUADS) {
+						flushBatch();
+					}
+				}
+
+				if (batchInstances.empty()) {
+					batchKey.brush = command.brush;
+					batchKey.features = command.features;
+					batchKey.textures = command.textures;
+					batchKey.filter = command.filter;
+					//every command in the batch has the same filter, so they can share the slot of the first
+					batchKey.painterDataSlot = command.painterDataSlot;
+				}
+
+				batchInstances.push_back(batchedQuads[command.quad]);
+
+				++frameStatistics.batchedDraws;
+			}
+
+			bool OGL33Renderer::flushBatch() {
+				if (batchInstances.empty()) {
+					return false;
+				}
+
+				bindProtocol({ batchKey.brush, batchKey.features | Enums::RenderFeatures::BATCHED });
+
+				bindPainterData(batchKey.painterDataSlot);
+
+				bindTextures(batchKey.brush, batchKey.textures);
+
+				batchArray.bind();
+
+				batchInstanceBuffer.bind();
+				//orphan the storage from the last batch instead of waiting for the GPU to be done with it
+				batchInstanceBuffer.setData(static_cast<ptrdiff_t>(sizeof(QuadInstance) * MACE__BATCH_MAXIMUM_QUADS), nullptr, GL_STREAM_DRAW);
+				batchInstanceBuffer.setDataRange(0, static_cast<ptrdiff_t>(sizeof(QuadInstance) * batchInstances.size()), batchInstances.data());
+
+				glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(batchInstances.size()));
+
+				++frameStatistics.drawCalls;
+				++frameStatistics.batches;
+
+				batchInstances.clear();
+
+				ogl::checkGLError(__LINE__, __FILE__, "Internal Error: Failed to draw batch");
+
+				return true;
+			}
+
+			OGL33Painter::OGL33Painter(OGL33Renderer* const r, Painter* const p) : PainterImpl(p), renderer(r) {}
+
+			void OGL33Painter::init() {
+				savedWorldMatrix = painter->getEntity()->getWorldMatrix();
+
+				renderer->setEntityData(painter->getID(), savedWorldMatrix);
+			}
+
+			void OGL33Painter::destroy() {
+				//the renderer is kept instead of looking up the current window, which doesn't exist on the update thread
+				if (painter->getID() != 0) {
+					renderer->remove(painter->getID());
+				}
+			}
+
+			void OGL33Painter::begin() {}
+
+			void OGL33Painter::end() {}
+
+			void OGL33Painter::clean() {
+				if (!painter->getEntity()->getProperty(Entity::INIT)) {
+					MACE__THROW(InitializationFailed, "Entity is not initializd.");
+				}
+
+				//the entity composed it's world matrix when it was cleaned
+				const Matrix<float, 4>& worldMatrix = painter->getEntity()->getWorldMatrix();
+
+				if (worldMatrix == savedWorldMatrix) {
+					return;
+				}
+
+				renderer->setEntityData(painter->getID(), worldMatrix);
+
+				savedWorldMatrix = worldMatrix;
+			}
+
+			void OGL33Painter::loadSettings(const Painter::State& state, const Painter::StateFields changed) {
+				currentState = &state;
+				changedFields |= changed;
+			}
+
+			void OGL33Painter::bindTexture(const Texture& t, const Enums::TextureSlot slot) {
+				textures[static_cast<Index>(slot)] = t;
+			}
+
+			void OGL33Painter::draw(const Model& m, const Enums::Brush brush, const Enums::RenderFeatures feat) {
+				renderer->recordDraw(this, m, brush, feat, nullptr, 0);
+			}
 
-				m.bind();
-				m.draw();
+			void OGL33Painter::drawInstanced(const Model& m, const Enums::Brush brush, const Enums::RenderFeatures feat, const InstanceData* instances, const Size count) {
+				renderer->recordDraw(this, m, brush, feat, instances, count);
 			}
 		}//ogl
 	}//gfx
@@ -0,0 +1,520 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2016 Liav Turkia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+#include <MACE/Graphics/Particles.h>
+
+#include <algorithm>
+#include <thread>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#	define MACE__PARTICLES_SSE 1
+#	include <xmmintrin.h>
+#endif
+
+namespace mc {
+	namespace gfx {
+		namespace {
+			//handing work to other threads has a cost, so small emitters are always simulated on the calling thread
+			MACE_CONSTEXPR const Size MINIMUM_PARTICLES_PER_THREAD = 8192;
+
+			struct ParticleArrays {
+				float* positionX;
+				float* positionY;
+				float* velocityX;
+				float* velocityY;
+				float* rotation;
+				float* angularVelocity;
+				float* age;
+				float* lifetime;
+			};
+
+			struct InstanceSettings {
+				float startSize, endSize;
+				Color startColor, endColor;
+			};
+
+			void integrate(const ParticleArrays& p, const Index begin, const Index end, const float delta, const float accelX, const float accelY) {
+				Index i = begin;
+#ifdef MACE__PARTICLES_SSE
+				const __m128 dt = _mm_set1_ps(delta);
+				const __m128 ax = _mm_set1_ps(accelX * delta);
+				const __m128 ay = _mm_set1_ps(accelY * delta);
+
+				for (; i + 4 <= end; i += 4) {
+					const __m128 vx = _mm_add_ps(_mm_loadu_ps(p.velocityX + i), ax);
+					const __m128 vy = _mm_add_ps(_mm_loadu_ps(p.velocityY + i), ay);
+					_mm_storeu_ps(p.velocityX + i, vx);
+					_mm_storeu_ps(p.velocityY + i, vy);
+
+					_mm_storeu_ps(p.positionX + i, _mm_add_ps(_mm_loadu_ps(p.positionX + i), _mm_mul_ps(vx, dt)));
+					_mm_storeu_ps(p.positionY + i, _mm_add_ps(_mm_loadu_ps(p.positionY + i), _mm_mul_ps(vy, dt)));
+					_mm_storeu_ps(p.rotation + i, _mm_add_ps(_mm_loadu_ps(p.rotation + i), _mm_mul_ps(_mm_loadu_ps(p.angularVelocity + i), dt)));
+					_mm_storeu_ps(p.age + i, _mm_add_ps(_mm_loadu_ps(p.age + i), dt));
+				}
+#endif
+				for (; i < end; ++i) {
+					p.velocityX[i] += accelX * delta;
+					p.velocityY[i] += accelY * delta;
+					p.positionX[i] += p.velocityX[i] * delta;
+					p.positionY[i] += p.velocityY[i] * delta;
+					p.rotation[i] += p.angularVelocity[i] * delta;
+					p.age[i] += delta;
+				}
+			}
+
+			void writeInstanceRange(const ParticleArrays& p, InstanceData* out, const Index begin, const Index end, const InstanceSettings& settings) {
+				const float sizeRange = settings.endSize - settings.startSize;
+				const Color colorRange = Color(settings.endColor.r - settings.startColor.r, settings.endColor.g - settings.startColor.g,
+											   settings.endColor.b - settings.startColor.b, settings.endColor.a - settings.startColor.a);
+
+				Index i = begin;
+#ifdef MACE__PARTICLES_SSE
+				const __m128 startSize = _mm_set1_ps(settings.startSize), deltaSize = _mm_set1_ps(sizeRange);
+				const __m128 startR = _mm_set1_ps(settings.startColor.r), deltaR = _mm_set1_ps(colorRange.r);
+				const __m128 startG = _mm_set1_ps(settings.startColor.g), deltaG = _mm_set1_ps(colorRange.g);
+				const __m128 startB = _mm_set1_ps(settings.startColor.b), deltaB = _mm_set1_ps(colorRange.b);
+				const __m128 startA = _mm_set1_ps(settings.startColor.a), deltaA = _mm_set1_ps(colorRange.a);
+
+				for (; i + 4 <= end; i += 4) {
+					const __m128 t = _mm_div_ps(_mm_loadu_ps(p.age + i), _mm_loadu_ps(p.lifetime + i));
+
+					//each register holds one field of 4 particles, and transposing them turns them into 4 InstanceData
+					__m128 x = _mm_loadu_ps(p.positionX + i);
+					__m128 y = _mm_loadu_ps(p.positionY + i);
+					__m128 s = _mm_add_ps(startSize, _mm_mul_ps(deltaSize, t));
+					__m128 rot = _mm_loadu_ps(p.rotation + i);
+					_MM_TRANSPOSE4_PS(x, y, s, rot);
+
+					__m128 r = _mm_add_ps(startR, _mm_mul_ps(deltaR, t));
+					__m128 g = _mm_add_ps(startG, _mm_mul_ps(deltaG, t));
+					__m128 b = _mm_add_ps(startB, _mm_mul_ps(deltaB, t));
+					__m128 a = _mm_add_ps(startA, _mm_mul_ps(deltaA, t));
+					_MM_TRANSPOSE4_PS(r, g, b, a);
+
+					_mm_storeu_ps(&out[i].x, x);
+					_mm_storeu_ps(&out[i].r, r);
+					_mm_storeu_ps(&out[i + 1].x, y);
+					_mm_storeu_ps(&out[i + 1].r, g);
+					_mm_storeu_ps(&out[i + 2].x, s);
+					_mm_storeu_ps(&out[i + 2].r, b);
+					_mm_storeu_ps(&out[i + 3].x, rot);
+					_mm_storeu_ps(&out[i + 3].r, a);
+				}
+#endif
+				for (; i < end; ++i) {
+					const float t = p.age[i] / p.lifetime[i];
+
+					InstanceData& instance = out[i];
+					instance.x = p.positionX[i];
+					instance.y = p.positionY[i];
+					instance.scale = settings.startSize + sizeRange * t;
+					instance.rotation = p.rotation[i];
+					instance.r = settings.startColor.r + colorRange.r * t;
+					instance.g = settings.startColor.g + colorRange.g * t;
+					instance.b = settings.startColor.b + colorRange.b * t;
+					instance.a = settings.startColor.a + colorRange.a * t;
+				}
+			}
+		}//anon namespace
+
+		ParticleEmitter::ParticleEmitter() noexcept : ParticleEmitter(0) {}
+
+		ParticleEmitter::ParticleEmitter(const Size cap) : texture() {
+			setCapacity(cap);
+		}
+
+		ParticleEmitter::~ParticleEmitter() {
+			stopWorkers();
+		}
+
+		void ParticleEmitter::simulate(const float delta) {
+			const ParticleArrays arrays = {
+				particles.positionX.data(), particles.positionY.data(),
+				particles.velocityX.data(), particles.velocityY.data(),
+				particles.rotation.data(), particles.angularVelocity.data(),
+				particles.age.data(), particles.lifetime.data()
+			};
+
+			const InstanceSettings settings = { size.x(), size.y(), startColor, endColor };
+			const float accelX = acceleration.x(), accelY = acceleration.y();
+
+			pendingInstances.resize(particleCount);
+
+			//the instances are written in the same pass, while the particles are still in the cache
+			InstanceData* out = pendingInstances.data();
+			forEachRange(particleCount, [&arrays, out, &settings, delta, accelX, accelY](const Index begin, const Index end) {
+				integrate(arrays, begin, end, delta, accelX, accelY);
+				writeInstanceRange(arrays, out, begin, end, settings);
+			});
+
+			//iterate backwards, as killing a particle moves the last one into it's place
+			for (Index i = particleCount; i > 0; --i) {
+				if (particles.age[i - 1] >= particles.lifetime[i - 1]) {
+					kill(i - 1);
+				}
+			}
+
+			const Index firstSpawned = particleCount;
+
+			emissionAccumulator += emissionRate * delta;
+			if (emissionAccumulator >= 1.0f) {
+				const Size spawned = static_cast<Size>(emissionAccumulator);
+				emissionAccumulator -= static_cast<float>(spawned);
+
+				spawn(spawned);
+			}
+
+			//only a few particles are spawned every step, so they are written on this thread
+			pendingInstances.resize(particleCount);
+			writeInstanceRange(arrays, pendingInstances.data(), firstSpawned, particleCount, settings);
+
+			publishInstances();
+		}
+
+		void ParticleEmitter::emit(const Size count) {
+			spawn(count);
+			writeInstances();
+		}
+
+		void ParticleEmitter::clear() {
+			particleCount = 0;
+			emissionAccumulator = 0.0f;
+			writeInstances();
+		}
+
+		Size ParticleEmitter::getParticleCount() const {
+			return particleCount;
+		}
+
+		void ParticleEmitter::setCapacity(const Size cap) {
+			capacity = cap;
+			particleCount = std::min(particleCount, capacity);
+
+			particles.positionX.resize(capacity);
+			particles.positionY.resize(capacity);
+			particles.velocityX.resize(capacity);
+			particles.velocityY.resize(capacity);
+			particles.rotation.resize(capacity);
+			particles.angularVelocity.resize(capacity);
+			particles.age.resize(capacity);
+			particles.lifetime.resize(capacity);
+
+			pendingInstances.reserve(capacity);
+		}
+
+		Size ParticleEmitter::getCapacity() const {
+			return capacity;
+		}
+
+		void ParticleEmitter::setEmissionRate(const float rate) {
+			emissionRate = rate;
+		}
+
+		float ParticleEmitter::getEmissionRate() const {
+			return emissionRate;
+		}
+
+		void ParticleEmitter::setLifetime(const float minimum, const float maximum) {
+#ifdef MACE_DEBUG_CHECK_ARGS
+			if (minimum <= 0.0f || maximum < minimum) {
+				MACE__THROW(OutOfBounds, "Particle lifetime must be larger than 0 and the maximum must not be smaller than the minimum");
+			}
+#endif
+
+			lifetime = { minimum, maximum };
+		}
+
+		Vector<float, 2> ParticleEmitter::getLifetime() const {
+			return lifetime;
+		}
+
+		void ParticleEmitter::setVelocity(const Vector<float, 2>& minimum, const Vector<float, 2>& maximum) {
+			minimumVelocity = minimum;
+			maximumVelocity = maximum;
+		}
+
+		const Vector<float, 2>& ParticleEmitter::getMinimumVelocity() const {
+			return minimumVelocity;
+		}
+
+		const Vector<float, 2>& ParticleEmitter::getMaximumVelocity() const {
+			return maximumVelocity;
+		}
+
+		void ParticleEmitter::setAngularVelocity(const float minimum, const float maximum) {
+			angularVelocity = { minimum, maximum };
+		}
+
+		Vector<float, 2> ParticleEmitter::getAngularVelocity() const {
+			return angularVelocity;
+		}
+
+		void ParticleEmitter::setAcceleration(const Vector<float, 2>& accel) {
+			acceleration = accel;
+		}
+
+		const Vector<float, 2>& ParticleEmitter::getAcceleration() const {
+			return acceleration;
+		}
+
+		void ParticleEmitter::setSize(const float start, const float end) {
+			size = { start, end };
+		}
+
+		Vector<float, 2> ParticleEmitter::getSize() const {
+			return size;
+		}
+
+		void ParticleEmitter::setColor(const Color& start, const Color& end) {
+			startColor = start;
+			endColor = end;
+		}
+
+		const Color& ParticleEmitter::getStartColor() const {
+			return startColor;
+		}
+
+		const Color& ParticleEmitter::getEndColor() const {
+			return endColor;
+		}
+
+		void ParticleEmitter::setThreadCount(const Size threads) {
+			threadCount = std::max<Size>(1, threads);
+
+			//the calling thread is the last one
+			if (workers.size() >= threadCount) {
+				stopWorkers();
+			}
+		}
+
+		Size ParticleEmitter::getThreadCount() const {
+			return threadCount;
+		}
+
+		void ParticleEmitter::setTexture(const Texture& tex) {
+			if (tex != texture) {
+				makeDirty();
+
+				texture = tex;
+			}
+		}
+
+		Texture& ParticleEmitter::getTexture() {
+			makeDirty();
+
+			return texture;
+		}
+
+		const Texture& ParticleEmitter::getTexture() const {
+			return texture;
+		}
+
+		bool ParticleEmitter::operator==(const ParticleEmitter& other) const {
+			return Entity2D::operator==(other) && texture == other.texture && capacity == other.capacity
+				&& particleCount == other.particleCount && emissionRate == other.emissionRate;
+		}
+
+		bool ParticleEmitter::operator!=(const ParticleEmitter& other) const {
+			return !operator==(other);
+		}
+
+		void ParticleEmitter::onInit() {
+			lastUpdate = std::chrono::steady_clock::now();
+		}
+
+		void ParticleEmitter::onUpdate() {
+			const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			//if the application stalls, dont simulate the whole stall in one step
+			const float delta = std::min(std::chrono::duration<float>(now - lastUpdate).count(), 0.25f);
+			lastUpdate = now;
+
+			simulate(delta);
+		}
+
+		void ParticleEmitter::onRender(Painter& p) {
+			const std::unique_lock<std::mutex> guard(instanceMutex);
+
+			if (instances.empty()) {
+				return;
+			}
+
+			if (texture.isCreated()) {
+				p.setTexture(texture, Enums::TextureSlot::FOREGROUND);
+				p.drawInstances(Model::getQuad(), Enums::Brush::TEXTURE, Enums::RenderFeatures::DEFAULT | Enums::RenderFeatures::DISCARD_INVISIBLE, instances.data(), instances.size());
+			} else {
+				p.setForegroundColor(Colors::WHITE);
+				p.drawInstances(Model::getQuad(), Enums::Brush::COLOR, Enums::RenderFeatures::DEFAULT & ~Enums::RenderFeatures::TEXTURE, instances.data(), instances.size());
+			}
+		}
+
+		void ParticleEmitter::onDestroy() {
+			if (texture.isCreated()) {
+				texture.destroy();
+			}
+		}
+
+		void ParticleEmitter::onClean() {}
+
+		void ParticleEmitter::spawn(const Size count) {
+			const Size spawned = std::min(count, capacity - particleCount);
+
+			std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+			const auto between = [this, &distribution](const float minimum, const float maximum) {
+				return minimum + (maximum - minimum) * distribution(random);
+			};
+
+			for (Index i = particleCount; i < particleCount + spawned; ++i) {
+				particles.positionX[i] = 0.0f;
+				particles.positionY[i] = 0.0f;
+				particles.velocityX[i] = between(minimumVelocity.x(), maximumVelocity.x());
+				particles.velocityY[i] = between(minimumVelocity.y(), maximumVelocity.y());
+				particles.rotation[i] = 0.0f;
+				particles.angularVelocity[i] = between(angularVelocity.x(), angularVelocity.y());
+				particles.age[i] = 0.0f;
+				particles.lifetime[i] = between(lifetime.x(), lifetime.y());
+			}
+
+			particleCount += spawned;
+		}
+
+		void ParticleEmitter::kill(const Index particle) {
+			const Index last = --particleCount;
+
+			particles.positionX[particle] = particles.positionX[last];
+			particles.positionY[particle] = particles.positionY[last];
+			particles.velocityX[particle] = particles.velocityX[last];
+			particles.velocityY[particle] = particles.velocityY[last];
+			particles.rotation[particle] = particles.rotation[last];
+			particles.angularVelocity[particle] = particles.angularVelocity[last];
+			particles.age[particle] = particles.age[last];
+			particles.lifetime[particle] = particles.lifetime[last];
+
+			pendingInstances[particle] = pendingInstances[last];
+		}
+
+		void ParticleEmitter::writeInstances() {
+			pendingInstances.resize(particleCount);
+
+			const ParticleArrays arrays = {
+				particles.positionX.data(), particles.positionY.data(),
+				particles.velocityX.data(), particles.velocityY.data(),
+				particles.rotation.data(), particles.angularVelocity.data(),
+				particles.age.data(), particles.lifetime.data()
+			};
+
+			const InstanceSettings settings = { size.x(), size.y(), startColor, endColor };
+
+			InstanceData* out = pendingInstances.data();
+			forEachRange(particleCount, [&arrays, out, &settings](const Index begin, const Index end) {
+				writeInstanceRange(arrays, out, begin, end, settings);
+			});
+
+			publishInstances();
+		}
+
+		void ParticleEmitter::publishInstances() {
+			bool changed;
+			{
+				//the renderer only ever holds the lock while it reads the finished buffer
+				const std::unique_lock<std::mutex> guard(instanceMutex);
+				instances.swap(pendingInstances);
+
+				//an emitter that had no particles and still has none draws the same thing
+				changed = !instances.empty() || !pendingInstances.empty();
+			}
+
+			//the last draws are replayed until the emitter is made dirty, so new instances have to make it dirty
+			if (changed) {
+				makeDirty();
+			}
+		}
+
+		void ParticleEmitter::forEachRange(const Size count, const std::function<void(const Index, const Index)>& func) {
+			const Size usedThreads = std::max<Size>(1, std::min<Size>(threadCount, count / MINIMUM_PARTICLES_PER_THREAD));
+			if (usedThreads <= 1) {
+				func(0, count);
+				return;
+			}
+
+			//keep every range a multiple of 4 so only the last one has a scalar tail
+			const Size rangeSize = ((count / usedThreads) + 3) & ~static_cast<Size>(3);
+
+			//new workers are given the generation before this job, as they may only start running after it was incremented
+			while (workers.size() < usedThreads - 1) {
+				const Index worker = workers.size();
+				workers.emplace_back(&ParticleEmitter::runWorker, this, worker, workerGeneration);
+			}
+
+			{
+				const std::unique_lock<std::mutex> guard(workerMutex);
+				workerJob = &func;
+				workerRangeSize = rangeSize;
+				activeWorkers = usedThreads - 1;
+				busyWorkers = usedThreads - 1;
+				++workerGeneration;
+			}
+			workerStart.notify_all();
+
+			func(rangeSize * (usedThreads - 1), count);
+
+			std::unique_lock<std::mutex> guard(workerMutex);
+			workerFinish.wait(guard, [this] () {
+				return busyWorkers == 0;
+			});
+			workerJob = nullptr;
+		}
+
+		void ParticleEmitter::runWorker(const Index worker, Size generation) {
+			std::unique_lock<std::mutex> guard(workerMutex);
+
+			while (true) {
+				workerStart.wait(guard, [this, &generation] () {
+					return stoppingWorkers || workerGeneration != generation;
+				});
+
+				if (stoppingWorkers) {
+					return;
+				}
+
+				generation = workerGeneration;
+
+				//there may be more workers than the current job needs
+				if (worker >= activeWorkers) {
+					continue;
+				}
+
+				const std::function<void(const Index, const Index)>& job = *workerJob;
+				const Index begin = worker * workerRangeSize;
+
+				guard.unlock();
+				job(begin, begin + workerRangeSize);
+				guard.lock();
+
+				if (--busyWorkers == 0) {
+					workerFinish.notify_one();
+				}
+			}
+		}
+
+		void ParticleEmitter::stopWorkers() {
+			{
+				const std::unique_lock<std::mutex> guard(workerMutex);
+				stoppingWorkers = true;
+			}
+			workerStart.notify_all();
+
+			for (std::thread& worker : workers) {
+				worker.join();
+			}
+			workers.clear();
+
+			stoppingWorkers = false;
+		}
+	}//gfx
+}//mc
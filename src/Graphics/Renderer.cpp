@@ -28,6 +28,13 @@ namespace mc {
 				resized = false;
 			}
 
+			frameStatistics = RenderStatistics();
+			frameStart = std::chrono::steady_clock::now();
+			++frameCount;
+
+			picking = SubscriberCounter::hasSubscribers();
+			frameStatistics.picking = picking;
+
 			onSetUp(win);
 		}//setUp
 
@@ -51,8 +58,27 @@ namespace mc {
 			}
 #endif
 
+			//the entity may be destroyed after this, so it can't be sent HOVER_LEAVE anymore
+			if (eventRouter.hovered == renderQueue[id - 1]) {
+				eventRouter.hovered = nullptr;
+				eventRouter.hoveredID = 0;
+			}
+
 			renderQueue[id - 1] = nullptr;
-		}
+		}//remove
+
+		GraphicsEntity* Renderer::getPickedEntity(const EntityID id, const Size frame) const {
+			if (id == 0 || id > renderQueue.size()) {
+				return nullptr;
+			}
+
+			//the entity that had this ID in that frame was removed, and another one was given it afterwards
+			if (frame <= queuedFrames[id - 1]) {
+				return nullptr;
+			}
+
+			return renderQueue[id - 1];
+		}//getPickedEntity
 
 		void Renderer::flagResize() {
 			resized = true;
@@ -66,17 +92,102 @@ namespace mc {
 
 		void Renderer::tearDown(gfx::WindowModule* win) {
 			onTearDown(win);
+
+			const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+			frameStatistics.frameTime = std::chrono::duration<float, std::milli>(now - frameStart).count();
+			//implementations only measure how long presenting took
+			frameStatistics.cpuTime = frameStatistics.frameTime - frameStatistics.presentTime;
+			if (lastPresent != std::chrono::steady_clock::time_point()) {
+				frameStatistics.frameInterval = std::chrono::duration<float, std::milli>(now - lastPresent).count();
+			}
+			lastPresent = now;
+
+			statistics = frameStatistics;
 		}//tearDown
 
-		void Renderer::checkInput(gfx::WindowModule*) {
-			GraphicsEntity* hovered = getEntityAt(gfx::Input::getMouseX(), gfx::Input::getMouseY());
+		void Renderer::checkInput(gfx::WindowModule* win) {
+			if (!SubscriberCounter::hasSubscribers()) {
+				//nothing would receive the events, so finding the entity under the mouse can be skipped
+				eventRouter.hovered = nullptr;
+				eventRouter.hoveredID = 0;
+
+				const std::unique_lock<std::mutex> guard(eventRouter.pendingMutex);
+				eventRouter.pendingEvents.clear();
+				return;
+			} else if (!picking) {
+				//the last frame was rendered without entity IDs, so another one has to be rendered with them first
+				win->makeDirty();
+				return;
+			}
 
-			if (hovered != nullptr) {
-				hovered->hover();
+			const int mouseX = gfx::Input::getMouseX(), mouseY = gfx::Input::getMouseY();
+
+			GraphicsEntity* hovered = getEntityAt(mouseX, mouseY);
+			//getPainter() is called on a const reference so it doesn't make the entity dirty
+			const EntityID hoveredID = hovered == nullptr ? 0 : static_cast<const GraphicsEntity*>(hovered)->getPainter().getID();
+
+			Event e = Event();
+			e.mouseX = mouseX;
+			e.mouseY = mouseY;
+
+			if (hovered != eventRouter.hovered) {
+				//if the previous entity was removed since the last time input was checked, Renderer::remove() cleared it
+				if (eventRouter.hovered != nullptr) {
+					Event leave = e;
+					leave.type = Event::HOVER_LEAVE;
+					leave.target = eventRouter.hovered;
+					EventRouter::dispatch(leave);
+				}
+
+				if (hovered != nullptr) {
+					Event enter = e;
+					enter.type = Event::HOVER_ENTER;
+					enter.target = hovered;
+					EventRouter::dispatch(enter);
+				}
+
+				eventRouter.hovered = hovered;
+				eventRouter.hoveredID = hoveredID;
 			}
 
+			std::vector<Event> pending;
+			{
+				const std::unique_lock<std::mutex> guard(eventRouter.pendingMutex);
+				pending.swap(eventRouter.pendingEvents);
+			}
+
+			if (hovered != nullptr) {
+				Event hover = e;
+				hover.type = Event::HOVER;
+				hover.target = hovered;
+				EventRouter::dispatch(hover);
+
+				for (Event& queued : pending) {
+					queued.mouseX = mouseX;
+					queued.mouseY = mouseY;
+					queued.target = hovered;
+					EventRouter::dispatch(queued);
+				}
+			}
 		}//checkInput
 
+		bool Renderer::beginCache(Entity* en, const Index id, const bool stale) {
+			return onBeginCache(en, id, stale);
+		}//beginCache
+
+		void Renderer::endCache(Entity* en, const Index id) {
+			onEndCache(en, id);
+		}//endCache
+
+		void Renderer::recordParallel(Entity* en) {
+			onRecordParallel(en);
+		}//recordParallel
+
+		void Renderer::finishRecording() {
+			onFinishRecording();
+		}//finishRecording
+
 		void Renderer::destroy() {
 			onDestroy();
 		}//destroy()
@@ -117,14 +228,93 @@ namespace mc {
 			return context;
 		}
 
+		EventRouter & Renderer::getEventRouter() {
+			return eventRouter;
+		}
+
+		const EventRouter & Renderer::getEventRouter() const {
+			return eventRouter;
+		}
+
+		const RenderStatistics & Renderer::getStatistics() const {
+			return statistics;
+		}
+
+		bool Renderer::isPickingEnabled() const {
+			return picking;
+		}
+
+		bool Renderer::hasPendingResults() const {
+			return false;
+		}
+
+		bool Renderer::onBeginCache(Entity*, const Index, const bool) {
+			return true;
+		}
+
+		void Renderer::onEndCache(Entity*, const Index) {}
+
+		void Renderer::onRecordParallel(Entity* en) {
+			record(en);
+		}
+
+		void Renderer::onFinishRecording() {}
+
+		void Renderer::record(Entity* en) {
+			en->record();
+		}
+
+		void EventRouter::queueEvent(const Event & e) {
+			const std::unique_lock<std::mutex> guard(pendingMutex);
+			pendingEvents.push_back(e);
+		}
+
+		void EventRouter::dispatch(Event & e) {
+#ifdef MACE_DEBUG_INTERNAL_ERRORS
+			if (e.target == nullptr) {
+				MACE__THROW(NullPointer, "Internal Error: Event dispatched without a target");
+			}
+#endif
+
+			std::vector<Entity*> path;
+			for (Entity* en = e.target->getParent(); en != nullptr; en = en->getParent()) {
+				path.push_back(en);
+			}
+
+			//capture goes from the root down to the target
+			e.phase = Event::Phase::CAPTURE;
+			for (auto it = path.rbegin(); it != path.rend() && e.isPropagating(); ++it) {
+				(*it)->handleEvent(e);
+			}
+
+			if (!e.isPropagating()) {
+				return;
+			}
+
+			e.phase = Event::Phase::TARGET;
+			e.target->handleEvent(e);
+
+			//and bubbling goes from the target up to the root
+			e.phase = Event::Phase::BUBBLE;
+			for (auto it = path.begin(); it != path.end() && e.isPropagating(); ++it) {
+				(*it)->handleEvent(e);
+			}
+		}
+
+		EntityID EventRouter::getHoveredID() const {
+			return hoveredID;
+		}
+
 		EntityID Renderer::pushEntity(GraphicsEntity * const entity) {
 			for (EntityID i = 0; i < renderQueue.size(); ++i) {
 				if (renderQueue[i] == nullptr) {
 					renderQueue[i] = entity;
+					queuedFrames[i] = frameCount;
 					return i;
 				}
 			}
 			renderQueue.push_back(entity);
+			queuedFrames.push_back(frameCount);
 			return renderQueue.size() - 1;
 		}//pushEntity(protocol, entity)
 
@@ -175,16 +365,45 @@ namespace mc {
 		}
 
 		void Painter::draw(const Model& m, const Enums::Brush brush, const Enums::RenderFeatures feat) {
-			impl->loadSettings(state);
+			if (recording) {
+				record(m, brush, feat, nullptr, 0);
+			}
+
+			impl->loadSettings(state, changedFields);
+			changedFields = 0;
 			impl->draw(m, brush, feat);
 		}
 
+		void Painter::drawInstances(const Model& m, const Enums::Brush brush, const Enums::RenderFeatures feat, const InstanceData* instances, const Size count) {
+			if (count == 0) {
+				return;
+			}
+
+#ifdef MACE_DEBUG_CHECK_ARGS
+			if (instances == nullptr) {
+				MACE__THROW(NullPointer, "Instance data given to Painter::drawInstances() must not be null");
+			}
+#endif
+
+			if (recording) {
+				record(m, brush, feat, instances, count);
+			}
+
+			impl->loadSettings(state, changedFields);
+			changedFields = 0;
+			impl->drawInstanced(m, brush, feat | Enums::RenderFeatures::INSTANCED, instances, count);
+		}
+
 		const GraphicsEntity * const Painter::getEntity() const {
 			return entity;
 		}
 
 		void Painter::setTexture(const Texture & t, const Enums::TextureSlot& slot) {
-			t.bind(static_cast<unsigned int>(slot));
+			if (recording) {
+				recordedTextures.push_back({ t, slot, recordedDraws.size() });
+			}
+
+			impl->bindTexture(t, slot);
 			if (slot == Enums::TextureSlot::FOREGROUND) {
 				//the member functions set DirtyFlags accordingly
 				setForegroundColor(t.getHue());
@@ -230,11 +449,15 @@ namespace mc {
 		}
 
 		void Painter::setForegroundColor(const Color & col) {
+			change(Painter::FOREGROUND_COLOR);
+
 			state.foregroundColor = col;
 
 		}
 
 		Color & Painter::getForegroundColor() {
+			change(Painter::FOREGROUND_COLOR);
+
 			return state.foregroundColor;
 		}
 
@@ -243,10 +466,14 @@ namespace mc {
 		}
 
 		void Painter::setForegroundTransform(const Vector<float, 4>& trans) {
+			change(Painter::FOREGROUND_TRANSFORM);
+
 			state.foregroundTransform = trans;
 		}
 
 		Vector<float, 4>& Painter::getForegroundTransform() {
+			change(Painter::FOREGROUND_TRANSFORM);
+
 			return state.foregroundTransform;
 		}
 
@@ -255,10 +482,14 @@ namespace mc {
 		}
 
 		void Painter::setBackgroundColor(const Color & col) {
+			change(Painter::BACKGROUND_COLOR);
+
 			state.backgroundColor = col;
 		}
 
 		Color & Painter::getBackgroundColor() {
+			change(Painter::BACKGROUND_COLOR);
+
 			return state.backgroundColor;
 		}
 
@@ -267,10 +498,14 @@ namespace mc {
 		}
 
 		void Painter::setBackgroundTransform(const Vector<float, 4>& trans) {
+			change(Painter::BACKGROUND_TRANSFORM);
+
 			state.backgroundTransform = trans;
 		}
 
 		Vector<float, 4>& Painter::getBackgroundTransform() {
+			change(Painter::BACKGROUND_TRANSFORM);
+
 			return state.backgroundTransform;
 		}
 
@@ -279,10 +514,14 @@ namespace mc {
 		}
 
 		void Painter::setMaskColor(const Color & col) {
+			change(Painter::MASK_COLOR);
+
 			state.maskColor = col;
 		}
 
 		Color & Painter::getMaskColor() {
+			change(Painter::MASK_COLOR);
+
 			return state.maskColor;
 		}
 
@@ -291,10 +530,14 @@ namespace mc {
 		}
 
 		void Painter::setMaskTransform(const Vector<float, 4>& trans) {
+			change(Painter::MASK_TRANSFORM);
+
 			state.maskTransform = trans;
 		}
 
 		Vector<float, 4>& Painter::getMaskTransform() {
+			change(Painter::MASK_TRANSFORM);
+
 			return state.maskTransform;
 		}
 
@@ -316,10 +559,14 @@ namespace mc {
 		}
 
 		void Painter::setFilter(const Matrix<float, 4, 4> & col) {
+			change(Painter::FILTER);
+
 			state.filter = col;
 		}
 
 		Matrix<float, 4, 4>& Painter::getFilter() {
+			change(Painter::FILTER);
+
 			return state.filter;
 		}
 
@@ -332,10 +579,14 @@ namespace mc {
 		}
 
 		void Painter::setData(const Vector<float, 4> & col) {
+			change(Painter::DATA);
+
 			state.data = col;
 		}
 
 		Vector<float, 4> & Painter::getData() {
+			change(Painter::DATA);
+
 			return state.data;
 		}
 
@@ -344,10 +595,14 @@ namespace mc {
 		}
 
 		void Painter::setTransformation(const TransformMatrix & trans) {
+			change(Painter::TRANSFORMATION);
+
 			state.transformation = trans;
 		}
 
 		TransformMatrix & Painter::getTransformation() {
+			change(Painter::TRANSFORMATION);
+
 			return state.transformation;
 		}
 
@@ -356,6 +611,8 @@ namespace mc {
 		}
 
 		void Painter::setOpacity(const float opacity) {
+			change(Painter::FILTER);
+
 			state.filter[3][3] = opacity;
 		}
 
@@ -372,6 +629,8 @@ namespace mc {
 		}
 
 		void Painter::translate(const float x, const float y, const float z) {
+			change(Painter::TRANSFORMATION);
+
 			state.transformation.translate(x, y, z);
 		}
 
@@ -380,6 +639,8 @@ namespace mc {
 		}
 
 		void Painter::rotate(const float x, const float y, const float z) {
+			change(Painter::TRANSFORMATION);
+
 			state.transformation.rotate(x, y, z);
 		}
 
@@ -388,31 +649,98 @@ namespace mc {
 		}
 
 		void Painter::scale(const float x, const float y, const float z) {
+			change(Painter::TRANSFORMATION);
+
 			state.transformation.scale(x, y, z);
 		}
 
 		void Painter::resetTransform() {
+			change(Painter::TRANSFORMATION);
+
 			state.transformation.reset();
 		}
 
 		void Painter::push() {
-			stateStack.push(state);
+			//nothing is saved until it changes
+			pushedFields.push_back(0);
 		}
 
 		void Painter::pop() {
-			state = stateStack.top();
-			stateStack.pop();
+#ifdef MACE_DEBUG_CHECK_ARGS
+			if (pushedFields.empty()) {
+				MACE__THROW(OutOfBounds, "Painter::pop() was called more times than Painter::push()");
+			}
+#endif
+
+			const StateFields restored = pushedFields.back();
+			pushedFields.pop_back();
+
+			//every field is saved at most once per push, so the saved values of this push are the last ones
+			for (StateFields remaining = restored; remaining != 0; savedFields.pop_back()) {
+				const StateField field = savedFields.back();
+				remaining &= ~field;
+
+				switch (field) {
+				case Painter::FOREGROUND_COLOR:
+					state.foregroundColor = savedColors.back();
+					savedColors.pop_back();
+					break;
+				case Painter::BACKGROUND_COLOR:
+					state.backgroundColor = savedColors.back();
+					savedColors.pop_back();
+					break;
+				case Painter::MASK_COLOR:
+					state.maskColor = savedColors.back();
+					savedColors.pop_back();
+					break;
+				case Painter::FOREGROUND_TRANSFORM:
+					state.foregroundTransform = savedVectors.back();
+					savedVectors.pop_back();
+					break;
+				case Painter::BACKGROUND_TRANSFORM:
+					state.backgroundTransform = savedVectors.back();
+					savedVectors.pop_back();
+					break;
+				case Painter::MASK_TRANSFORM:
+					state.maskTransform = savedVectors.back();
+					savedVectors.pop_back();
+					break;
+				case Painter::DATA:
+					state.data = savedVectors.back();
+					savedVectors.pop_back();
+					break;
+				case Painter::TRANSFORMATION:
+					state.transformation = savedTransformations.back();
+					savedTransformations.pop_back();
+					break;
+				case Painter::FILTER:
+					state.filter = savedFilters.back();
+					savedFilters.pop_back();
+					break;
+				default:
+					MACE__THROW(AssertionFailed, "Internal Error: Unknown saved painter state field");
+				}
+			}
+
+			changedFields |= restored;
+			++stateVersion;
 		}
 
 		void Painter::reset() {
+			change(Painter::ALL_FIELDS);
+
 			state = Painter::State();
 		}
 
 		void Painter::setState(const State & s) {
+			change(Painter::ALL_FIELDS);
+
 			state = s;
 		}
 
 		Painter::State & Painter::getState() {
+			change(Painter::ALL_FIELDS);
+
 			return state;
 		}
 
@@ -420,17 +748,77 @@ namespace mc {
 			return state;
 		}
 
+		Size Painter::getStateVersion() const {
+			return stateVersion;
+		}
+
+		void Painter::change(const StateFields fields) {
+			if (!pushedFields.empty()) {
+				const StateFields unsaved = fields & ~pushedFields.back();
+
+				for (StateFields bit = Painter::FOREGROUND_COLOR; bit <= Painter::FILTER; bit <<= 1) {
+					if ((unsaved & bit) == 0) {
+						continue;
+					}
+
+					const StateField field = static_cast<StateField>(bit);
+					switch (field) {
+					case Painter::FOREGROUND_COLOR:
+						savedColors.push_back(state.foregroundColor);
+						break;
+					case Painter::BACKGROUND_COLOR:
+						savedColors.push_back(state.backgroundColor);
+						break;
+					case Painter::MASK_COLOR:
+						savedColors.push_back(state.maskColor);
+						break;
+					case Painter::FOREGROUND_TRANSFORM:
+						savedVectors.push_back(state.foregroundTransform);
+						break;
+					case Painter::BACKGROUND_TRANSFORM:
+						savedVectors.push_back(state.backgroundTransform);
+						break;
+					case Painter::MASK_TRANSFORM:
+						savedVectors.push_back(state.maskTransform);
+						break;
+					case Painter::DATA:
+						savedVectors.push_back(state.data);
+						break;
+					case Painter::TRANSFORMATION:
+						savedTransformations.push_back(state.transformation);
+						break;
+					case Painter::FILTER:
+					default:
+						savedFilters.push_back(state.filter);
+						break;
+					}
+
+					savedFields.push_back(field);
+				}
+
+				pushedFields.back() |= unsaved;
+			}
+
+			changedFields |= fields;
+			++stateVersion;
+		}
+
 		const EntityID & Painter::getID() const {
 			return id;
 		}
 
+		void Painter::setImpl(const std::shared_ptr<PainterImpl>& implementation, const EntityID entityID) {
+			impl = implementation;
+			id = entityID;
+		}
+
 		Painter Painter::operator=(const Painter& right) {
 			return Painter(right);
 		}
 
 		bool Painter::operator==(const Painter & other) const {
 			return impl == other.impl&& id == other.id && entity == other.entity
-				&& state == other.state && stateStack == other.stateStack;
+				&& state == other.state && pushedFields == other.pushedFields && savedFields == other.savedFields;
 		}
 
 		bool Painter::operator!=(const Painter & other) const {
@@ -464,14 +852,94 @@ namespace mc {
 		}
 
 		void Painter::destroy() {
+			//the implementation frees the ID for another entity
 			impl->destroy();
 			id = 0;
+
+			//the recorded models and textures may be destroyed with the entity
+			recordedDraws.clear();
+			recordedTextures.clear();
+			recorded = false;
 		}
 
 		void Painter::clean() {
 			impl->clean();
 		}
 
+		void Painter::beginRecording() {
+			recordedDraws.clear();
+			recordedTextures.clear();
+			recordedStates.clear();
+			recordedChanges.clear();
+			recordedInstances.clear();
+
+			recordedWorldMatrix = entity->getWorldMatrix();
+			//if the entity is made dirty while recording, it's recording is already out of date
+			recordedRevision = entity->getRevision();
+
+			recording = true;
+			recorded = false;
+		}
+
+		void Painter::endRecording() {
+			recordedEndState = state;
+
+			recording = false;
+			recorded = true;
+		}
+
+		bool Painter::replay() {
+			//the world matrix is composed when the entity is cleaned, so unlike the metrics, checking it doesn't walk up the tree
+			if (!recorded || entity->getRevision() != recordedRevision || entity->getWorldMatrix() != recordedWorldMatrix) {
+				return false;
+			}
+
+			Index texture = 0, loadedState = 0;
+			for (Index i = 0; i < recordedDraws.size(); ++i) {
+				for (; texture < recordedTextures.size() && recordedTextures[texture].draw == i; ++texture) {
+					impl->bindTexture(recordedTextures[texture].texture, recordedTextures[texture].slot);
+				}
+
+				const RecordedDraw& draw = recordedDraws[i];
+
+				//the implementation may have loaded anything since the last replay, so the first state is entirely new
+				impl->loadSettings(recordedStates[draw.state], i == 0 ? Painter::ALL_FIELDS : draw.state == loadedState ? 0 : recordedChanges[draw.state]);
+				loadedState = draw.state;
+				if ((draw.features & Enums::RenderFeatures::INSTANCED) != Enums::RenderFeatures::NONE) {
+					impl->drawInstanced(draw.model, draw.brush, draw.features, recordedInstances.data() + draw.instanceOffset, draw.instanceCount);
+				} else {
+					impl->draw(draw.model, draw.brush, draw.features);
+				}
+			}
+
+			//textures set after the last draw still have to be set for the next recording
+			for (; texture < recordedTextures.size(); ++texture) {
+				impl->bindTexture(recordedTextures[texture].texture, recordedTextures[texture].slot);
+			}
+
+			state = recordedEndState;
+			changedFields = Painter::ALL_FIELDS;
+			++stateVersion;
+
+			return true;
+		}
+
+		void Painter::record(const Model& m, const Enums::Brush brush, const Enums::RenderFeatures feat, const InstanceData* instances, const Size count) {
+			//changedFields is only cleared by draws, which are all recorded, so it is what changed since the last recorded state
+			if (recordedStates.empty() || changedFields != 0) {
+				recordedStates.push_back(state);
+				recordedChanges.push_back(recordedStates.size() == 1 ? Painter::ALL_FIELDS : changedFields);
+			}
+
+			RecordedDraw draw = { m, brush, feat, recordedStates.size() - 1, recordedInstances.size(), count };
+			if (instances != nullptr) {
+				draw.features = feat | Enums::RenderFeatures::INSTANCED;
+				recordedInstances.insert(recordedInstances.end(), instances, instances + count);
+			}
+
+			recordedDraws.push_back(draw);
+		}
+
 		bool Painter::State::operator==(const State & other) const {
 			return transformation == other.transformation && foregroundColor == other.foregroundColor
 				&& backgroundColor == other.backgroundColor && maskColor == other.maskColor
@@ -519,7 +987,14 @@ namespace mc {
 
 		void GraphicsEntity::onRender() {
 			painter.begin();
-			onRender(painter);
+
+			//if nothing changed, onRender(Painter&) would draw the same thing as last time
+			if (!painter.replay()) {
+				painter.beginRecording();
+				onRender(painter);
+				painter.endRecording();
+			}
+
 			painter.end();
 		}
 
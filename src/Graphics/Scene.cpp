@@ -0,0 +1,514 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2016 Liav Turkia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+#include <MACE/Graphics/Scene.h>
+#include <MACE/Graphics/Context.h>
+#include <MACE/Graphics/Window.h>
+#include <MACE/Utility/MappedFile.h>
+#include <MACE/Core/System.h>
+#include <MACE/Core/Error.h>
+
+#include <cstring>
+#include <fstream>
+
+namespace mc {
+	namespace gfx {
+		namespace {
+			const char SCENE_MAGIC[4] = { 'M', 'C', 'S', 'N' };
+
+			const char* const BUILTIN_FONT_NAMES[] = { "MC/Fonts/CODE", "MC/Fonts/SANS", "MC/Fonts/SERIF" };
+			const Fonts BUILTIN_FONTS[] = { Fonts::CODE, Fonts::SANS, Fonts::SERIF };
+
+			//the string table is only ever accessed through these, which check that the string fits inside of it
+			std::uint32_t readStringLength(const Byte* table, const std::uint32_t tableSize, const std::uint32_t offset, const Size charSize) {
+				if (offset > tableSize || tableSize - offset < sizeof(std::uint32_t)) {
+					MACE__THROW(BadFile, "String offset " + std::to_string(offset) + " is outside of the string table");
+				}
+
+				std::uint32_t length;
+				std::memcpy(&length, table + offset, sizeof(std::uint32_t));
+
+				if ((tableSize - offset - sizeof(std::uint32_t)) / charSize < length) {
+					MACE__THROW(BadFile, "String at offset " + std::to_string(offset) + " is longer than the string table");
+				}
+
+				return length;
+			}
+
+			std::string readString(const Byte* table, const std::uint32_t tableSize, const std::uint32_t offset) {
+				const std::uint32_t length = readStringLength(table, tableSize, offset, sizeof(char));
+
+				return std::string(reinterpret_cast<const char*>(table + offset + sizeof(std::uint32_t)), length);
+			}
+
+			std::wstring readText(const Byte* table, const std::uint32_t tableSize, const std::uint32_t offset) {
+				const std::uint32_t length = readStringLength(table, tableSize, offset, sizeof(std::uint32_t));
+
+				std::wstring out = std::wstring(length, L'\0');
+				const Byte* codePoints = table + offset + sizeof(std::uint32_t);
+				for (std::uint32_t i = 0; i < length; ++i) {
+					std::uint32_t c;
+					std::memcpy(&c, codePoints + (i * sizeof(std::uint32_t)), sizeof(std::uint32_t));
+					out[i] = static_cast<wchar_t>(c);
+				}
+
+				return out;
+			}
+
+			//Texture's copy constructor resets the hue, so the result is assigned to an existing Texture instead of being returned
+			void readTexture(Texture& out, const SceneFormat::TextureReference& ref, const Byte* table, const std::uint32_t tableSize) {
+				if (ref.name == SceneFormat::NO_STRING) {
+					out = Texture();
+					return;
+				}
+
+				const std::string name = readString(table, tableSize, ref.name);
+
+				GraphicsContext* context = gfx::getCurrentWindow()->getContext();
+				if (!context->hasTexture(name)) {
+					context->createTexture(name, Texture::createFromFile(name));
+				}
+
+				out = Texture(context->getTexture(name), Color(ref.hue[0], ref.hue[1], ref.hue[2], ref.hue[3]));
+				out.setTransform({ ref.transform[0], ref.transform[1], ref.transform[2], ref.transform[3] });
+			}
+
+			template<typename T>
+			void writeVector(std::ofstream& out, const std::vector<T>& vec) {
+				if (!vec.empty()) {
+					out.write(reinterpret_cast<const char*>(vec.data()), static_cast<std::streamsize>(vec.size() * sizeof(T)));
+				}
+			}
+		}//anon namespace
+
+		void Scene::load(const std::string & path) {
+			load(path.c_str());
+		}
+
+		void Scene::load(const char * path) {
+#ifdef MACE_BIG_ENDIAN
+			MACE__THROW(BadFile, "Scene files can only be loaded on little-endian systems");
+#endif
+
+			const os::MappedFile file(path);
+
+			const Byte* data = file.getData();
+			const Size fileSize = file.getSize();
+
+			if (fileSize < sizeof(SceneFormat::Header)) {
+				MACE__THROW(BadFile, std::string(path) + " is too small to be a scene file");
+			}
+
+			SceneFormat::Header header;
+			std::memcpy(&header, data, sizeof(SceneFormat::Header));
+
+			if (std::memcmp(header.magic, SCENE_MAGIC, sizeof(SCENE_MAGIC)) != 0) {
+				MACE__THROW(BadFile, std::string(path) + " is not a scene file");
+			} else if (header.version != SceneFormat::VERSION) {
+				MACE__THROW(BadFile, std::string(path) + " has unsupported scene version " + std::to_string(header.version));
+			} else if (header.entityOffset % alignof(SceneFormat::EntityRecord) != 0 || header.componentOffset % alignof(SceneFormat::ComponentRecord) != 0) {
+				MACE__THROW(BadFile, std::string(path) + " has misaligned records");
+			} else if (header.entityOffset > fileSize || (fileSize - header.entityOffset) / sizeof(SceneFormat::EntityRecord) < header.entityCount
+					   || header.componentOffset > fileSize || (fileSize - header.componentOffset) / sizeof(SceneFormat::ComponentRecord) < header.componentCount
+					   || header.stringOffset > fileSize || fileSize - header.stringOffset < header.stringSize) {
+				MACE__THROW(BadFile, std::string(path) + " is truncated");
+			}
+
+			Size typeTotal = 0;
+			for (Index i = 0; i < SceneFormat::ENTITY_TYPES; ++i) {
+				typeTotal += header.typeCounts[i];
+			}
+			if (typeTotal != header.entityCount) {
+				MACE__THROW(BadFile, std::string(path) + " has mismatched entity counts");
+			}
+
+			clear();
+
+			//the mapping is page aligned and the offsets were checked, so the records can be used in place
+			const SceneFormat::EntityRecord* entityRecords = reinterpret_cast<const SceneFormat::EntityRecord*>(data + header.entityOffset);
+			const SceneFormat::ComponentRecord* componentRecords = reinterpret_cast<const SceneFormat::ComponentRecord*>(data + header.componentOffset);
+			const Byte* strings = data + header.stringOffset;
+
+			//reserving exactly enough means the vectors never reallocate, so pointers to their elements stay valid
+			groups.reserve(header.typeCounts[static_cast<Index>(Enums::SceneEntityType::GROUP)]);
+			images.reserve(header.typeCounts[static_cast<Index>(Enums::SceneEntityType::IMAGE)]);
+			progressBars.reserve(header.typeCounts[static_cast<Index>(Enums::SceneEntityType::PROGRESS_BAR)]);
+			texts.reserve(header.typeCounts[static_cast<Index>(Enums::SceneEntityType::TEXT)]);
+			buttons.reserve(header.typeCounts[static_cast<Index>(Enums::SceneEntityType::BUTTON)]);
+			alignments.reserve(header.componentCount);
+
+			std::vector<Entity*> created = std::vector<Entity*>(header.entityCount, nullptr);
+			//the records are checked against the counts in the header, as going over them would reallocate the vectors
+			Size typeLoaded[SceneFormat::ENTITY_TYPES] = {};
+			std::map<std::uint32_t, Font> fonts;
+
+			Texture texture = Texture();
+
+			for (Index i = 0; i < header.entityCount; ++i) {
+				const SceneFormat::EntityRecord& record = entityRecords[i];
+
+				if (record.parent > i) {
+					MACE__THROW(BadFile, std::string(path) + " has an entity before it's parent");
+				}
+
+				if (record.type < SceneFormat::ENTITY_TYPES && typeLoaded[record.type]++ >= header.typeCounts[record.type]) {
+					MACE__THROW(BadFile, std::string(path) + " has more entities of type " + std::to_string(record.type) + " than it's header says");
+				}
+
+				Entity* e;
+
+				switch (static_cast<Enums::SceneEntityType>(record.type)) {
+					case Enums::SceneEntityType::GROUP:
+						groups.emplace_back();
+						e = &groups.back();
+						break;
+					case Enums::SceneEntityType::IMAGE:
+						images.emplace_back();
+						readTexture(texture, record.textures[0], strings, header.stringSize);
+						images.back().setTexture(texture);
+						e = &images.back();
+						break;
+					case Enums::SceneEntityType::PROGRESS_BAR: {
+						progressBars.emplace_back(record.progress[0], record.progress[1], record.progress[2]);
+						ProgressBar& bar = progressBars.back();
+						readTexture(texture, record.textures[0], strings, header.stringSize);
+						bar.setBackgroundTexture(texture);
+						readTexture(texture, record.textures[1], strings, header.stringSize);
+						bar.setForegroundTexture(texture);
+						readTexture(texture, record.textures[2], strings, header.stringSize);
+						bar.setSelectionTexture(texture);
+						e = &bar;
+						break;
+					}
+					case Enums::SceneEntityType::TEXT: {
+						//fonts are cached so every Text using the same font doesn't load it again
+						auto font = fonts.find(record.font);
+						if (font == fonts.end()) {
+							const std::string fontName = readString(strings, header.stringSize, record.font);
+
+							Font loaded = Font();
+							bool builtin = false;
+							for (Index f = 0; f < os::getArraySize(BUILTIN_FONT_NAMES); ++f) {
+								if (fontName == BUILTIN_FONT_NAMES[f]) {
+									loaded = Font(BUILTIN_FONTS[f]);
+									builtin = true;
+									break;
+								}
+							}
+							if (!builtin) {
+								loaded = Font::loadFont(fontName);
+							}
+
+							font = fonts.insert(std::make_pair(record.font, loaded)).first;
+						}
+
+						Font textFont = font->second;
+						textFont.setSize(record.fontSize);
+
+						texts.emplace_back(readText(strings, header.stringSize, record.text), textFont);
+						Text& text = texts.back();
+						readTexture(texture, record.textures[0], strings, header.stringSize);
+						text.setTexture(texture);
+						text.setVerticalAlign(static_cast<Enums::VerticalAlign>(record.verticalAlign));
+						text.setHorizontalAlign(static_cast<Enums::HorizontalAlign>(record.horizontalAlign));
+						e = &text;
+						break;
+					}
+					case Enums::SceneEntityType::BUTTON: {
+						buttons.emplace_back();
+						Button& button = buttons.back();
+						readTexture(texture, record.textures[0], strings, header.stringSize);
+						button.setTexture(texture);
+						readTexture(texture, record.textures[1], strings, header.stringSize);
+						button.setHoverTexture(texture);
+						readTexture(texture, record.textures[2], strings, header.stringSize);
+						button.setClickedTexture(texture);
+						readTexture(texture, record.textures[3], strings, header.stringSize);
+						button.setDisabledTexture(texture);
+						e = &button;
+						break;
+					}
+					default:
+						MACE__THROW(BadFile, std::string(path) + " has an entity of unknown type " + std::to_string(record.type));
+				}
+
+				TransformMatrix transformation = TransformMatrix();
+				transformation.translation = { record.translation[0], record.translation[1], record.translation[2] };
+				transformation.rotation = { record.rotation[0], record.rotation[1], record.rotation[2] };
+				transformation.scaler = { record.scale[0], record.scale[1], record.scale[2] };
+				e->setTransformation(transformation);
+
+				//the state of the entity comes from the scene it is loaded into, not the file
+				const EntityProperties stateProperties = Entity::DEAD | Entity::INIT | Entity::DIRTY;
+				EntityProperties properties = static_cast<EntityProperties>((e->getProperties() & stateProperties) | (record.properties & ~stateProperties));
+				e->setProperties(properties);
+
+				if (record.firstComponent > header.componentCount || header.componentCount - record.firstComponent < record.componentCount) {
+					MACE__THROW(BadFile, std::string(path) + " has an entity with components outside of the component table");
+				}
+
+				for (Index c = record.firstComponent; c < record.firstComponent + record.componentCount; ++c) {
+					const SceneFormat::ComponentRecord& component = componentRecords[c];
+
+					if (static_cast<Enums::SceneComponentType>(component.type) == Enums::SceneComponentType::ALIGNMENT) {
+						//entities can share component ranges, so there could be more components than the table has
+						if (alignments.size() >= header.componentCount) {
+							MACE__THROW(BadFile, std::string(path) + " has more components than it's header says");
+						}
+
+						alignments.emplace_back(static_cast<Enums::VerticalAlign>(component.data[0]), static_cast<Enums::HorizontalAlign>(component.data[1]));
+						e->addComponent(alignments.back());
+					} else {
+						MACE__THROW(BadFile, std::string(path) + " has a component of unknown type " + std::to_string(component.type));
+					}
+				}
+
+				if (record.parent == 0) {
+					root.addChild(e);
+				} else {
+					created[record.parent - 1]->addChild(e);
+				}
+
+				created[i] = e;
+			}
+		}
+
+		void Scene::clear() {
+			root.clearChildren();
+
+			groups.clear();
+			images.clear();
+			progressBars.clear();
+			texts.clear();
+			buttons.clear();
+
+			alignments.clear();
+		}
+
+		Group & Scene::getRoot() {
+			return root;
+		}
+
+		const Group & Scene::getRoot() const {
+			return root;
+		}
+
+		Size Scene::size() const {
+			return groups.size() + images.size() + progressBars.size() + texts.size() + buttons.size();
+		}
+
+		void SceneWriter::setFontName(const Font & f, const std::string & name) {
+			fontNames[f.getID()] = name;
+		}
+
+		void SceneWriter::write(const Entity & root, const std::string & path) {
+			entities.clear();
+			components.clear();
+			strings.clear();
+			stringOffsets.clear();
+			std::memset(typeCounts, 0, sizeof(typeCounts));
+
+			for (const Entity* child : root.getChildren()) {
+				writeEntity(*child, 0);
+			}
+
+			SceneFormat::Header header = SceneFormat::Header();
+			std::memcpy(header.magic, SCENE_MAGIC, sizeof(SCENE_MAGIC));
+			header.version = SceneFormat::VERSION;
+			header.entityCount = static_cast<std::uint32_t>(entities.size());
+			header.componentCount = static_cast<std::uint32_t>(components.size());
+			std::memcpy(header.typeCounts, typeCounts, sizeof(typeCounts));
+			header.entityOffset = sizeof(SceneFormat::Header);
+			header.componentOffset = header.entityOffset + static_cast<std::uint32_t>(entities.size() * sizeof(SceneFormat::EntityRecord));
+			header.stringOffset = header.componentOffset + static_cast<std::uint32_t>(components.size() * sizeof(SceneFormat::ComponentRecord));
+			header.stringSize = static_cast<std::uint32_t>(strings.size());
+
+			std::ofstream out = std::ofstream(path, std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!out.is_open()) {
+				MACE__THROW(BadFile, "Unable to open " + path + " for writing");
+			}
+
+			out.write(reinterpret_cast<const char*>(&header), sizeof(SceneFormat::Header));
+			writeVector(out, entities);
+			writeVector(out, components);
+			writeVector(out, strings);
+
+			if (!out.good()) {
+				MACE__THROW(BadFile, "Error writing to " + path);
+			}
+		}
+
+		void SceneWriter::writeEntity(const Entity & e, const std::uint32_t parent) {
+			//letters are recreated by their Text when it is cleaned
+			if (dynamic_cast<const Letter*>(&e) != nullptr) {
+				return;
+			}
+
+			SceneFormat::EntityRecord record = SceneFormat::EntityRecord();
+			record.parent = parent;
+			//these properties describe the current state of the entity, and shouldn't be loaded
+			record.properties = static_cast<std::uint8_t>(e.getProperties() & ~(Entity::DEAD | Entity::INIT | Entity::DIRTY));
+			for (Index i = 0; i < SceneFormat::TEXTURE_SLOTS; ++i) {
+				record.textures[i].name = SceneFormat::NO_STRING;
+			}
+			record.text = SceneFormat::NO_STRING;
+			record.font = SceneFormat::NO_STRING;
+
+			const TransformMatrix& transformation = e.getTransformation();
+			for (Index i = 0; i < 3; ++i) {
+				record.translation[i] = transformation.translation[i];
+				record.rotation[i] = transformation.rotation[i];
+				record.scale[i] = transformation.scaler[i];
+			}
+
+			bool writeChildren = true;
+
+			Enums::SceneEntityType type = Enums::SceneEntityType::GROUP;
+			if (const Text* text = dynamic_cast<const Text*>(&e)) {
+				type = Enums::SceneEntityType::TEXT;
+
+				const Font& font = text->getFont();
+
+				std::string fontName;
+				if (fontNames.find(font.getID()) != fontNames.end()) {
+					fontName = fontNames[font.getID()];
+				} else {
+					for (Index f = 0; f < os::getArraySize(BUILTIN_FONTS); ++f) {
+						if (Font(BUILTIN_FONTS[f]).getID() == font.getID()) {
+							fontName = BUILTIN_FONT_NAMES[f];
+							break;
+						}
+					}
+				}
+
+				if (fontName.empty()) {
+					MACE__THROW(ObjectNotFound, "Font used by Text has no name. Use SceneWriter::setFontName()");
+				}
+
+				record.text = writeText(text->getText());
+				record.font = writeString(fontName);
+				record.fontSize = static_cast<std::uint32_t>(font.getSize());
+				record.verticalAlign = static_cast<std::uint8_t>(text->getVerticalAlign());
+				record.horizontalAlign = static_cast<std::uint8_t>(text->getHorizontalAlign());
+				record.textures[0] = writeTexture(text->getTexture());
+
+				//the only children of a Text are it's letters
+				writeChildren = false;
+			} else if (const Button* button = dynamic_cast<const Button*>(&e)) {
+				type = Enums::SceneEntityType::BUTTON;
+				record.textures[0] = writeTexture(button->getTexture());
+				record.textures[1] = writeTexture(button->getHoverTexture());
+				record.textures[2] = writeTexture(button->getClickedTexture());
+				record.textures[3] = writeTexture(button->getDisabledTexture());
+			} else if (const ProgressBar* bar = dynamic_cast<const ProgressBar*>(&e)) {
+				type = Enums::SceneEntityType::PROGRESS_BAR;
+				record.textures[0] = writeTexture(bar->getBackgroundTexture());
+				record.textures[1] = writeTexture(bar->getForegroundTexture());
+				record.textures[2] = writeTexture(bar->getSelectionTexture());
+				record.progress[0] = bar->getMinimum();
+				record.progress[1] = bar->getMaximum();
+				record.progress[2] = bar->getProgress();
+			} else if (const Image* image = dynamic_cast<const Image*>(&e)) {
+				type = Enums::SceneEntityType::IMAGE;
+				record.textures[0] = writeTexture(image->getTexture());
+			}
+
+			record.type = static_cast<std::uint8_t>(type);
+			++typeCounts[static_cast<Index>(type)];
+
+			record.firstComponent = static_cast<std::uint32_t>(components.size());
+			for (const SmartPointer<Component>& com : e.getComponents()) {
+				if (const AlignmentComponent* alignment = dynamic_cast<const AlignmentComponent*>(com.get())) {
+					SceneFormat::ComponentRecord component = SceneFormat::ComponentRecord();
+					component.type = static_cast<std::uint8_t>(Enums::SceneComponentType::ALIGNMENT);
+					component.data[0] = static_cast<std::uint8_t>(alignment->getVerticalAlign());
+					component.data[1] = static_cast<std::uint8_t>(alignment->getHorizontalAlign());
+					components.push_back(component);
+				}
+			}
+			record.componentCount = static_cast<std::uint16_t>(components.size() - record.firstComponent);
+
+			entities.push_back(record);
+
+			if (writeChildren) {
+				const std::uint32_t index = static_cast<std::uint32_t>(entities.size());
+				for (const Entity* child : e.getChildren()) {
+					writeEntity(*child, index);
+				}
+			}
+		}
+
+		SceneFormat::TextureReference SceneWriter::writeTexture(const Texture & tex) {
+			SceneFormat::TextureReference ref = SceneFormat::TextureReference();
+			ref.name = SceneFormat::NO_STRING;
+
+			if (!tex.isCreated()) {
+				return ref;
+			}
+
+			const Color& hue = tex.getHue();
+			ref.hue[0] = hue.r;
+			ref.hue[1] = hue.g;
+			ref.hue[2] = hue.b;
+			ref.hue[3] = hue.a;
+
+			const Vector<float, 4>& transform = tex.getTransform();
+			for (Index i = 0; i < 4; ++i) {
+				ref.transform[i] = transform[i];
+			}
+
+			//textures don't know their own name, so it has to be found by comparing them to every texture in the context
+			const GraphicsContext* context = gfx::getCurrentWindow()->getContext();
+			for (const std::pair<const std::string, Texture>& named : context->getTextures()) {
+				Texture candidate(named.second, hue);
+				candidate.setTransform(transform);
+
+				if (candidate == tex) {
+					ref.name = writeString(named.first);
+					return ref;
+				}
+			}
+
+			MACE__THROW(ObjectNotFound, "Texture is not registered in the GraphicsContext. Use GraphicsContext::createTexture() to name it.");
+		}
+
+		std::uint32_t SceneWriter::writeString(const std::string & s) {
+			auto existing = stringOffsets.find(s);
+			if (existing != stringOffsets.end()) {
+				return existing->second;
+			}
+
+			const std::uint32_t offset = static_cast<std::uint32_t>(strings.size());
+			const std::uint32_t length = static_cast<std::uint32_t>(s.size());
+
+			strings.resize(strings.size() + sizeof(std::uint32_t) + s.size());
+			std::memcpy(strings.data() + offset, &length, sizeof(std::uint32_t));
+			std::memcpy(strings.data() + offset + sizeof(std::uint32_t), s.data(), s.size());
+			//keep the next string aligned
+			strings.resize((strings.size() + 3) & ~static_cast<Size>(3), 0);
+
+			stringOffsets[s] = offset;
+			return offset;
+		}
+
+		std::uint32_t SceneWriter::writeText(const std::wstring & s) {
+			const std::uint32_t offset = static_cast<std::uint32_t>(strings.size());
+			const std::uint32_t length = static_cast<std::uint32_t>(s.size());
+
+			strings.resize(strings.size() + sizeof(std::uint32_t) * (s.size() + 1));
+			std::memcpy(strings.data() + offset, &length, sizeof(std::uint32_t));
+			for (Index i = 0; i < s.size(); ++i) {
+				const std::uint32_t c = static_cast<std::uint32_t>(s[i]);
+				std::memcpy(strings.data() + offset + sizeof(std::uint32_t) * (i + 1), &c, sizeof(std::uint32_t));
+			}
+
+			return offset;
+		}
+	}//gfx
+}//mc
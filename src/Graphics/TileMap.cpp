@@ -0,0 +1,329 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2016 Liav Turkia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+#include <MACE/Graphics/TileMap.h>
+
+#include <algorithm>
+
+namespace mc {
+	namespace gfx {
+		TileMap::TileMap() noexcept : TileMap(0, 0, 0) {}
+
+		TileMap::TileMap(const Size cols, const Size rowNum, const Size layerNum, const Size chunk) : chunkSize(chunk), texture() {
+#ifdef MACE_DEBUG_CHECK_ARGS
+			if (chunk == 0) {
+				MACE__THROW(OutOfBounds, "The chunk size of a TileMap must be larger than 0");
+			}
+#endif
+
+			resize(cols, rowNum, layerNum);
+		}
+
+		void TileMap::resize(const Size cols, const Size rowNum, const Size layerNum) {
+			const std::unique_lock<std::mutex> guard(tileMutex);
+
+			columns = cols;
+			rows = rowNum;
+			layers = layerNum;
+
+			tiles.assign(columns * rows * layers, EMPTY);
+
+			//the old models have to be destroyed on the rendering thread, so they are only marked as dirty here
+			chunkColumns = (columns + chunkSize - 1) / chunkSize;
+			chunkRows = (rows + chunkSize - 1) / chunkSize;
+			for (Chunk& chunk : chunks) {
+				chunk.dirty = true;
+			}
+			chunks.resize(std::max(chunks.size(), chunkColumns * chunkRows));
+
+			makeDirty();
+		}
+
+		void TileMap::setAtlasSize(const Size cols, const Size rowNum) {
+#ifdef MACE_DEBUG_CHECK_ARGS
+			if (cols == 0 || rowNum == 0) {
+				MACE__THROW(OutOfBounds, "A TileMap atlas must be at least 1 tile wide and tall");
+			}
+#endif
+
+			const std::unique_lock<std::mutex> guard(tileMutex);
+
+			atlasColumns = cols;
+			atlasRows = rowNum;
+
+			for (Chunk& chunk : chunks) {
+				chunk.dirty = true;
+			}
+
+			makeDirty();
+		}
+
+		Size TileMap::getAtlasColumns() const {
+			return atlasColumns;
+		}
+
+		Size TileMap::getAtlasRows() const {
+			return atlasRows;
+		}
+
+		void TileMap::setTile(const Index x, const Index y, const TileID tile, const Index layer) {
+			const std::unique_lock<std::mutex> guard(tileMutex);
+
+			TileID& current = tiles[getTileIndex(x, y, layer)];
+			if (current == tile) {
+				return;
+			}
+
+			current = tile;
+			chunks[(y / chunkSize) * chunkColumns + (x / chunkSize)].dirty = true;
+
+			makeDirty();
+		}
+
+		TileID TileMap::getTile(const Index x, const Index y, const Index layer) const {
+			const std::unique_lock<std::mutex> guard(tileMutex);
+
+			return tiles[getTileIndex(x, y, layer)];
+		}
+
+		void TileMap::fill(const TileID tile, const Index layer) {
+			const std::unique_lock<std::mutex> guard(tileMutex);
+
+#ifdef MACE_DEBUG_CHECK_ARGS
+			if (layer >= layers) {
+				MACE__THROW(OutOfBounds, "Layer " + std::to_string(layer) + " is out of bounds for a TileMap with " + std::to_string(layers) + " layers");
+			}
+#endif
+
+			const auto begin = tiles.begin() + static_cast<std::ptrdiff_t>(layer * columns * rows);
+			std::fill(begin, begin + static_cast<std::ptrdiff_t>(columns * rows), tile);
+
+			for (Chunk& chunk : chunks) {
+				chunk.dirty = true;
+			}
+
+			makeDirty();
+		}
+
+		Size TileMap::getColumns() const {
+			return columns;
+		}
+
+		Size TileMap::getRows() const {
+			return rows;
+		}
+
+		Size TileMap::getLayerCount() const {
+			return layers;
+		}
+
+		Size TileMap::getChunkSize() const {
+			return chunkSize;
+		}
+
+		Size TileMap::getChunkCount() const {
+			return chunkColumns * chunkRows;
+		}
+
+		Size TileMap::getDrawnChunkCount() const {
+			return drawnChunks;
+		}
+
+		void TileMap::setTexture(const Texture& tex) {
+			if (tex != texture) {
+				makeDirty();
+
+				texture = tex;
+			}
+		}
+
+		Texture& TileMap::getTexture() {
+			makeDirty();
+
+			return texture;
+		}
+
+		const Texture& TileMap::getTexture() const {
+			return texture;
+		}
+
+		bool TileMap::operator==(const TileMap& other) const {
+			return Entity2D::operator==(other) && texture == other.texture && columns == other.columns
+				&& rows == other.rows && layers == other.layers && tiles == other.tiles;
+		}
+
+		bool TileMap::operator!=(const TileMap& other) const {
+			return !operator==(other);
+		}
+
+		void TileMap::onInit() {}
+
+		void TileMap::onUpdate() {}
+
+		void TileMap::onRender(Painter& p) {
+			const std::unique_lock<std::mutex> guard(tileMutex);
+
+			drawnChunks = 0;
+
+			if (!texture.isCreated() || columns == 0 || rows == 0) {
+				return;
+			}
+
+			//culling is skipped if the map is rotated, as every chunk would have to be transformed
+			const Entity::Metrics metrics = getMetrics();
+			const bool cull = metrics.rotation == Vector<float, 3>({ 0, 0, 0 }) && metrics.inheritedRotation == Vector<float, 3>({ 0, 0, 0 });
+			const float chunkWidth = 2.0f * static_cast<float>(chunkSize) / static_cast<float>(columns);
+			const float chunkHeight = 2.0f * static_cast<float>(chunkSize) / static_cast<float>(rows);
+
+			p.setTexture(texture, Enums::TextureSlot::FOREGROUND);
+
+			for (Index y = 0; y < chunkRows; ++y) {
+				for (Index x = 0; x < chunkColumns; ++x) {
+					const Chunk& chunk = chunks[y * chunkColumns + x];
+					if (chunk.indexCount == 0) {
+						continue;
+					}
+
+					if (cull) {
+						const float left = (-1.0f + chunkWidth * static_cast<float>(x)) * metrics.scale.x() + metrics.translation.x() + metrics.inheritedTranslation.x();
+						const float right = left + chunkWidth * metrics.scale.x();
+						const float top = (1.0f - chunkHeight * static_cast<float>(y)) * metrics.scale.y() + metrics.translation.y() + metrics.inheritedTranslation.y();
+						const float bottom = top - chunkHeight * metrics.scale.y();
+
+						if (right < -1.0f || left > 1.0f || top < -1.0f || bottom > 1.0f) {
+							continue;
+						}
+					}
+
+					p.draw(chunk.model, Enums::Brush::TEXTURE, Enums::RenderFeatures::DEFAULT | Enums::RenderFeatures::DISCARD_INVISIBLE);
+					++drawnChunks;
+				}
+			}
+		}
+
+		void TileMap::onDestroy() {
+			const std::unique_lock<std::mutex> guard(tileMutex);
+
+			destroyChunks();
+
+			if (texture.isCreated()) {
+				texture.destroy();
+			}
+		}
+
+		void TileMap::onClean() {
+			const std::unique_lock<std::mutex> guard(tileMutex);
+
+			//chunks are built when cleaning instead of rendering, so rendering never creates models
+
+			//chunks left over from a larger map
+			for (Index i = chunkColumns * chunkRows; i < chunks.size(); ++i) {
+				if (chunks[i].indexCount > 0) {
+					chunks[i].model.destroy();
+				}
+			}
+			chunks.resize(chunkColumns * chunkRows);
+
+			for (Index i = 0; i < chunks.size(); ++i) {
+				if (chunks[i].dirty) {
+					buildChunk(i);
+				}
+			}
+		}
+
+		Index TileMap::getTileIndex(const Index x, const Index y, const Index layer) const {
+#ifdef MACE_DEBUG_CHECK_ARGS
+			if (x >= columns || y >= rows || layer >= layers) {
+				MACE__THROW(OutOfBounds, "Tile (" + std::to_string(x) + ", " + std::to_string(y) + ") on layer " + std::to_string(layer) + " is out of bounds for the TileMap");
+			}
+#endif
+
+			return (layer * rows + y) * columns + x;
+		}
+
+		void TileMap::buildChunk(const Index index) {
+			Chunk& chunk = chunks[index];
+
+			if (chunk.indexCount > 0) {
+				chunk.model.destroy();
+			}
+			chunk.model = Model();
+			chunk.indexCount = 0;
+			chunk.dirty = false;
+
+			const Index firstColumn = (index % chunkColumns) * chunkSize, firstRow = (index / chunkColumns) * chunkSize;
+			const Index lastColumn = std::min(firstColumn + chunkSize, columns), lastRow = std::min(firstRow + chunkSize, rows);
+
+			const float tileWidth = 2.0f / static_cast<float>(columns), tileHeight = 2.0f / static_cast<float>(rows);
+			const float atlasWidth = 1.0f / static_cast<float>(atlasColumns), atlasHeight = 1.0f / static_cast<float>(atlasRows);
+
+			std::vector<float> vertices, textureCoordinates;
+			std::vector<unsigned int> indices;
+
+			for (Index layer = 0; layer < layers; ++layer) {
+				for (Index y = firstRow; y < lastRow; ++y) {
+					for (Index x = firstColumn; x < lastColumn; ++x) {
+						const TileID tile = tiles[getTileIndex(x, y, layer)];
+						if (tile == EMPTY) {
+							continue;
+						}
+
+						const float left = -1.0f + tileWidth * static_cast<float>(x), right = left + tileWidth;
+						const float top = 1.0f - tileHeight * static_cast<float>(y), bottom = top - tileHeight;
+
+						const float u = static_cast<float>((tile - 1) % atlasColumns) * atlasWidth;
+						const float v = static_cast<float>((tile - 1) / atlasColumns) * atlasHeight;
+
+						const unsigned int first = static_cast<unsigned int>(vertices.size() / 3);
+
+						//same winding and texture coordinates as Model::getQuad()
+						vertices.insert(vertices.end(), {
+							left, bottom, 0.0f,
+							left, top, 0.0f,
+							right, top, 0.0f,
+							right, bottom, 0.0f
+						});
+						textureCoordinates.insert(textureCoordinates.end(), {
+							u, v + atlasHeight,
+							u, v,
+							u + atlasWidth, v,
+							u + atlasWidth, v + atlasHeight
+						});
+						indices.insert(indices.end(), {
+							first, first + 1, first + 3,
+							first + 1, first + 2, first + 3
+						});
+					}
+				}
+			}
+
+			if (indices.empty()) {
+				return;
+			}
+
+			chunk.model.init();
+			chunk.model.createVertices(vertices.size(), vertices.data(), Enums::PrimitiveType::TRIANGLES);
+			chunk.model.createIndices(indices.size(), indices.data());
+			chunk.model.createTextureCoordinates(textureCoordinates.size(), textureCoordinates.data());
+			chunk.indexCount = indices.size();
+		}
+
+		void TileMap::destroyChunks() {
+			for (Chunk& chunk : chunks) {
+				if (chunk.indexCount > 0) {
+					chunk.model.destroy();
+				}
+
+				chunk.model = Model();
+				chunk.indexCount = 0;
+				chunk.dirty = true;
+			}
+		}
+	}//gfx
+}//mc
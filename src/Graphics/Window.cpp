@@ -20,6 +20,9 @@ The above copyright notice and this permission notice shall be included in all c
 
 #include <mutex>
 #include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <unordered_map>
 #include <sstream>
@@ -31,6 +34,65 @@ The above copyright notice and this permission notice shall be included in all c
 namespace mc {
 	namespace gfx {
 		namespace {
+			//longest time in milliseconds that an idle window sleeps before checking if it is dirty
+#define MACE__WINDOW_IDLE_TIMEOUT 250
+			//microseconds that the frame pacer always spins for instead of sleeping
+#define MACE__PACER_MINIMUM_SPIN 500
+
+			//set on threads recording draws for a window, which don't have it's context
+			thread_local WindowModule* recordingWindow = nullptr;
+
+			/*
+			sleeping overshoots by an unpredictable amount, so the pacer wakes up early by the worst recent
+			overshoot and spins for the rest of the frame
+			*/
+			class FramePacer {
+			public:
+				using Clock = std::chrono::steady_clock;
+				using Duration = std::chrono::microseconds;
+
+				void setInterval(const Duration newInterval) {
+					interval = newInterval;
+					nextFrame = Clock::now();
+				}
+
+				/**
+				Waits until the next frame is due
+				*/
+				void wait() {
+					if (interval == Duration::zero()) {
+						return;
+					}
+
+					nextFrame += interval;
+
+					Clock::time_point now = Clock::now();
+					if (nextFrame <= now) {
+						//if a frame took too long, catching up would render a burst of frames
+						nextFrame = now;
+						return;
+					}
+
+					const Clock::time_point wakeUp = nextFrame - spinMargin;
+					if (wakeUp > now) {
+						std::this_thread::sleep_until(wakeUp);
+
+						//grows to the worst overshoot right away, but shrinks slowly so a single good sleep doesn't cause jitter
+						const Duration overshoot = std::chrono::duration_cast<Duration>(Clock::now() - wakeUp);
+						spinMargin = std::max(overshoot, spinMargin - spinMargin / 16);
+						spinMargin = std::min(std::max(spinMargin, Duration(MACE__PACER_MINIMUM_SPIN)), interval / 2);
+					}
+
+					while (Clock::now() < nextFrame) {
+						std::this_thread::yield();
+					}
+				}
+			private:
+				Duration interval = Duration::zero();
+				Duration spinMargin = Duration(MACE__PACER_MINIMUM_SPIN);
+				Clock::time_point nextFrame = Clock::now();
+			};//FramePacer
+
 			std::unordered_map< short int, Byte > keys = std::unordered_map< short int, Byte >();
 
 			int mouseX = -1;
@@ -122,7 +184,7 @@ namespace mc {
 				pushKeyEvent(static_cast<short int>(key), actions);
 			}
 
-			void onWindowMouseButton(GLFWwindow*, int button, int action, int mods) {
+			void onWindowMouseButton(GLFWwindow* window, int button, int action, int mods) {
 				Byte actions = 0x00;
 				if (action == GLFW_PRESS) {
 					actions |= Input::PRESSED;
@@ -148,6 +210,16 @@ namespace mc {
 
 				//in case that we dont have it mapped the same way that GLFW does, we add MOUSE_FIRST which is the offset to the mouse bindings.
 				pushKeyEvent(static_cast<short int>(button) + Input::MOUSE_FIRST, actions);
+
+				if (action == GLFW_PRESS || action == GLFW_RELEASE) {
+					Event e = Event();
+					e.type = action == GLFW_PRESS ? Event::PRESS : Event::RELEASE;
+					e.button = static_cast<short int>(button) + Input::MOUSE_FIRST;
+
+					WindowModule* win = convertGLFWWindowToModule(window);
+					win->getContext()->getRenderer()->getEventRouter().queueEvent(e);
+					win->wake();
+				}
 			}
 
 			void onWindowCursorPosition(GLFWwindow* window, double xpos, double ypos) {
@@ -156,6 +228,9 @@ namespace mc {
 
 				WindowModule* win = convertGLFWWindowToModule(window);
 				win->getLaunchConfig().onMouseMove(*win, mouseX, mouseY);
+
+				//the entity under the mouse may have changed
+				win->wake();
 			}
 
 			void onWindowScrollWheel(GLFWwindow* window, double xoffset, double yoffset) {
@@ -164,12 +239,22 @@ namespace mc {
 
 				WindowModule* win = convertGLFWWindowToModule(window);
 				win->getLaunchConfig().onScroll(*win, scrollX, scrollY);
+
+				Event e = Event();
+				e.type = Event::SCROLL;
+				e.scrollX = scrollX;
+				e.scrollY = scrollY;
+
+				win->getContext()->getRenderer()->getEventRouter().queueEvent(e);
+				win->wake();
 			}
 
 			void onWindowFramebufferResized(GLFWwindow* window, int, int) {
 				WindowModule* win = convertGLFWWindowToModule(window);
 				win->getContext()->getRenderer()->flagResize();
-				win->makeChildrenDirty();
+				//only entities that use the window ratios have to be recalculated. everything else just has to be redrawn
+				win->makeResizeDependentsDirty();
+				win->makeDirty();
 			}
 
 			void onWindowDamaged(GLFWwindow* window) {
@@ -207,7 +292,8 @@ namespace mc {
 					glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_API);
 
 					glfwWindowHint(GLFW_STENCIL_BITS, 8);
-					glfwWindowHint(GLFW_DEPTH_BITS, GLFW_DONT_CARE);
+					//frames that aren't drawn offscreen need a depth buffer for the opaque pass
+					glfwWindowHint(GLFW_DEPTH_BITS, 24);
 #ifdef MACE_DEBUG_OPENGL
 					glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, true);
 #endif
@@ -256,11 +342,7 @@ namespace mc {
 
 			context->init();
 
-			if (config.vsync) {
-				glfwSwapInterval(1);
-			} else {
-				glfwSwapInterval(0);
-			}
+			glfwSwapInterval(swapInterval);
 
 			glfwSetWindowUserPointer(window, this);
 
@@ -301,31 +383,18 @@ namespace mc {
 			try {
 				os::clearError(__LINE__, __FILE__);
 
-				//typedefs for chrono for readibility purposes
-				using Clock = std::chrono::steady_clock;
-				using TimeStamp = std::chrono::time_point<Clock>;
-				using Duration = std::chrono::microseconds;
-
-				//mutex for this function.
-				std::mutex mutex;
-
-				//now is set to be now() every loop, and the delta is calculated from now and last frame.
-				TimeStamp now = Clock::now();
-				//each time the frame is swapped, lastFrame is updated with the new time
-				TimeStamp lastFrame = Clock::now();
-
-				//this stores how many milliseconds it takes for the frame to swap.
-				Duration windowDelay = Duration::zero();
+				FramePacer pacer = FramePacer();
 
 				try {
-					const std::unique_lock<std::mutex> guard(mutex);//in case there is an exception, the unique lock will unlock the mutex
+					const std::unique_lock<std::mutex> guard(entityMutex);//in case there is an exception, the unique lock will unlock the mutex
 
 					configureThread();
 
 					Entity::init();
 
-					if (config.fps != 0) {
-						windowDelay = Duration(std::chrono::seconds(1)) / static_cast<long long>(config.fps);
+					//with vsync the swap waits for the display, so sleeping as well would only add latency
+					if (config.fps != 0 && !config.vsync) {
+						pacer.setInterval(FramePacer::Duration(std::chrono::seconds(1)) / static_cast<long long>(config.fps));
 					}
 
 					os::clearError(__LINE__, __FILE__);
@@ -339,16 +408,31 @@ namespace mc {
 				//we loop infinitely until break is called. break is called when an exception is thrown or MACE::isRunning is false
 				for (;;) {//( ;_;)
 					try {
+						bool recorded = false;
+
 						{
-							//thread doesn't own window, so we have to lock the mutex
-							const std::unique_lock<std::mutex> guard(mutex);//in case there is an exception, the unique lock will unlock the mutex
+							//the update thread modifies the entities, so they are only rendered while it is locked out
+							const std::unique_lock<std::mutex> guard(entityMutex);//in case there is an exception, the unique lock will unlock the mutex
 
 							if (getProperty(Entity::DIRTY)) {
 								context->getRenderer()->setUp(this);
+								//every draw is copied into the renderer, so this is a snapshot of the scene that can't change afterwards
 								Entity::render();
-								context->getRenderer()->tearDown(this);
+								//subtrees recorded on other threads read the entities, so they have to finish before they are unlocked
+								context->getRenderer()->finishRecording();
+								recorded = true;
 							}
+						}
 
+						//submitting and presenting only reads the snapshot, so the entities can be updated at the same time
+						if (recorded) {
+							context->getRenderer()->tearDown(this);
+						}
+
+						{
+							const std::unique_lock<std::mutex> guard(entityMutex);
+
+							//dispatches events to the entities
 							context->render();
 
 							if (!instance->isRunning()) {
@@ -357,12 +441,15 @@ namespace mc {
 
 						}
 
-						if (windowDelay != Duration::zero()) {
-							now = Clock::now();
-
-							std::this_thread::sleep_for(windowDelay - (now - lastFrame));
+						pacer.wait();
 
-							lastFrame = Clock::now();
+						if (config.idle && !context->getRenderer()->hasPendingResults()) {
+							std::unique_lock<std::mutex> guard(wakeMutex);
+							//the timeout is only a fallback in case the tree was made dirty without Entity::makeDirty()
+							wakeSignal.wait_for(guard, std::chrono::milliseconds(MACE__WINDOW_IDLE_TIMEOUT), [this]() {
+								return wakeRequested;
+							});
+							wakeRequested = false;
 						}
 					} catch (const std::exception& e) {
 						Error::handleError(e, instance);
@@ -375,7 +462,7 @@ namespace mc {
 				os::checkError(__LINE__, __FILE__, "A system error occurred during the window loop");
 
 				{
-					const std::unique_lock<std::mutex> guard(mutex);//in case there is an exception, the unique lock will unlock the mutex
+					const std::unique_lock<std::mutex> guard(entityMutex);//in case there is an exception, the unique lock will unlock the mutex
 					try {
 						Entity::destroy();
 
@@ -404,6 +491,17 @@ namespace mc {
 			//GLFW needs to be created from main thread
 			//we create a window in the main thread, then switch its context to the render thread
 			create();
+
+			swapInterval = 0;
+			if (config.vsync) {
+				//to reach the fps with vsync, frames are presented every n-th refresh. the video mode can only be read on this thread
+				swapInterval = 1;
+
+				const GLFWvidmode* mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+				if (config.fps != 0 && mode != nullptr && mode->refreshRate > static_cast<int>(config.fps)) {
+					swapInterval = static_cast<int>(std::lround(static_cast<double>(mode->refreshRate) / static_cast<double>(config.fps)));
+				}
+			}
 			
 			os::clearError(__LINE__, __FILE__);//sometimes an error comes from GLFW that we can ignore
 
@@ -416,8 +514,7 @@ namespace mc {
 		}
 
 		void WindowModule::update() {
-			std::mutex mutex;
-			const std::unique_lock<std::mutex> guard(mutex);
+			const std::unique_lock<std::mutex> guard(entityMutex);
 
 			glfwPollEvents();
 
@@ -426,11 +523,13 @@ namespace mc {
 
 		void WindowModule::destroy() {
 			{
-				std::mutex mutex;
-				const std::unique_lock<std::mutex> guard(mutex);
+				const std::unique_lock<std::mutex> guard(entityMutex);
 				setProperty(WindowModule::DESTROYED, true);
 			}
 
+			//an idle rendering thread wouldn't notice that it has to stop until it wakes up
+			wake();
+
 			windowThread.join();
 
 			os::checkError(__LINE__, __FILE__, "A system error occured while trying to destroy the WindowModule");
@@ -442,6 +541,19 @@ namespace mc {
 			os::clearError(__LINE__, __FILE__);//https://github.com/glfw/glfw/issues/1053
 		}//destroy
 
+		void WindowModule::wake() {
+			{
+				const std::unique_lock<std::mutex> guard(wakeMutex);
+				wakeRequested = true;
+			}
+
+			wakeSignal.notify_one();
+		}
+
+		void WindowModule::onDirty() {
+			wake();
+		}
+
 		std::string WindowModule::getName() const {
 			return "MACE/Window#" + std::string(config.title);
 		}//getName()
@@ -521,7 +633,10 @@ namespace mc {
 				&& onScroll == other.onScroll && onMouseMove == other.onMouseMove
 				&& terminateOnClose == other.terminateOnClose
 				&& decorated == other.decorated && fullscreen == other.fullscreen
-				&& resizable == other.resizable && vsync == other.vsync;
+				&& resizable == other.resizable && vsync == other.vsync
+				&& shaderCache == other.shaderCache && idle == other.idle
+				&& gpuBudget == other.gpuBudget && minimumRenderScale == other.minimumRenderScale
+				&& renderCacheBudget == other.renderCacheBudget;
 		}
 
 		bool WindowModule::LaunchConfig::operator!=(const LaunchConfig & other) const {
@@ -531,12 +646,20 @@ namespace mc {
 		WindowModule * getCurrentWindow() {
 			GLFWwindow* win = glfwGetCurrentContext();
 			if (win == nullptr) {
+				if (recordingWindow != nullptr) {
+					return recordingWindow;
+				}
+
 				MACE__THROW(NoRendererContext, "No renderer context in this thread");
 			}
 
 			return convertGLFWWindowToModule(win);
 		}
 
+		void setRecordingWindow(WindowModule * win) {
+			recordingWindow = win;
+		}
+
 		WindowModule * convertGLFWWindowToModule(GLFWwindow * win) {
 			WindowModule* windowModule = static_cast<WindowModule*>(glfwGetWindowUserPointer(win));
 			if (windowModule == nullptr) {
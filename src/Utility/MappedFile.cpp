@@ -0,0 +1,173 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2016 Liav Turkia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+#include <MACE/Utility/MappedFile.h>
+#include <MACE/Core/System.h>
+#include <MACE/Core/Error.h>
+
+#ifdef MACE_WINAPI
+#	define WIN32_LEAN_AND_MEAN
+#	include <windows.h>
+#	undef WIN32_LEAN_AND_MEAN
+#elif defined(MACE_POSIX)
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <cerrno>
+#endif
+
+namespace mc {
+	namespace os {
+		MappedFile::MappedFile() {}
+
+		MappedFile::MappedFile(const std::string & path) : MappedFile(path.c_str()) {}
+
+		MappedFile::MappedFile(const char * path) : MappedFile() {
+			init(path);
+		}
+
+		MappedFile::~MappedFile() {
+			if (isCreated()) {
+				destroy();
+			}
+		}
+
+		void MappedFile::init(const std::string & path) {
+			init(path.c_str());
+		}
+
+		void MappedFile::init(const char * path) {
+			os::clearError(__LINE__, __FILE__);
+
+			if (isCreated()) {
+				MACE__THROW(AssertionFailed, "Can\'t call init() on a MappedFile that is already mapped!");
+			}
+
+#ifdef MACE_WINAPI
+			file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+			if (file == INVALID_HANDLE_VALUE) {
+				const DWORD lastError = GetLastError();
+
+				if (lastError == ERROR_FILE_NOT_FOUND || lastError == ERROR_PATH_NOT_FOUND) {
+					MACE__THROW(FileNotFound, "File with name " + std::string(path) + " not found.");
+				} else {
+					MACE__THROW(BadFile, "Error opening " + std::string(path) + " with error from CreateFile " + std::to_string(lastError));
+				}
+			}
+
+			LARGE_INTEGER fileSize;
+			if (!GetFileSizeEx(file, &fileSize)) {
+				CloseHandle(file);
+				MACE__THROW(BadFile, "Error retrieving the size of " + std::string(path));
+			}
+
+			size = static_cast<Size>(fileSize.QuadPart);
+
+			if (size == 0) {
+				//CreateFileMapping fails on empty files, so there is nothing to map
+				mapping = nullptr;
+				data = nullptr;
+			} else {
+				mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (mapping == nullptr) {
+					CloseHandle(file);
+					MACE__THROW(BadFile, "Error creating file mapping for " + std::string(path) + ": " + std::to_string(GetLastError()));
+				}
+
+				data = static_cast<const Byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+				if (data == nullptr) {
+					CloseHandle(mapping);
+					CloseHandle(file);
+					MACE__THROW(BadFile, "Error mapping view of " + std::string(path) + ": " + std::to_string(GetLastError()));
+				}
+			}
+#elif defined(MACE_POSIX)
+			const int descriptor = open(path, O_RDONLY);
+
+			if (descriptor == -1) {
+				if (errno == ENOENT) {
+					MACE__THROW(FileNotFound, "File with name " + std::string(path) + " not found.");
+				} else {
+					MACE__THROW(BadFile, "Error opening " + std::string(path) + " with errno " + std::to_string(errno));
+				}
+			}
+
+			struct stat fileStats;
+			if (fstat(descriptor, &fileStats) == -1) {
+				close(descriptor);
+				MACE__THROW(BadFile, "Error retrieving the size of " + std::string(path) + " with errno " + std::to_string(errno));
+			}
+
+			size = static_cast<Size>(fileStats.st_size);
+
+			if (size == 0) {
+				//mmap fails with a length of 0, so there is nothing to map
+				data = nullptr;
+			} else {
+				void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+				if (mapped == MAP_FAILED) {
+					close(descriptor);
+					MACE__THROW(BadFile, "Error mapping " + std::string(path) + " with errno " + std::to_string(errno));
+				}
+
+				//the whole file is almost always read front to back
+				madvise(mapped, size, MADV_SEQUENTIAL);
+
+				data = static_cast<const Byte*>(mapped);
+			}
+
+			//the mapping stays valid after the descriptor is closed
+			close(descriptor);
+#endif
+
+			created = true;
+
+			os::clearError(__LINE__, __FILE__);
+		}
+
+		void MappedFile::destroy() {
+			if (!isCreated()) {
+				MACE__THROW(AssertionFailed, "Can\'t destroy a MappedFile that was never mapped!");
+			}
+
+#ifdef MACE_WINAPI
+			if (data != nullptr) {
+				UnmapViewOfFile(data);
+				CloseHandle(mapping);
+			}
+
+			CloseHandle(file);
+#elif defined(MACE_POSIX)
+			if (data != nullptr) {
+				munmap(const_cast<Byte*>(data), size);
+			}
+#endif
+
+			data = nullptr;
+			size = 0;
+			created = false;
+
+			os::clearError(__LINE__, __FILE__);
+		}
+
+		const Byte * MappedFile::getData() const {
+			return data;
+		}
+
+		Size MappedFile::getSize() const {
+			return size;
+		}
+
+		bool MappedFile::isCreated() const {
+			return created;
+		}
+	}//os
+}//mc
@@ -10,6 +10,11 @@ The above copyright notice and this permission notice shall be included in all c
 #include <MACE/Utility/Transform.h>
 #include <MACE/Utility/Math.h>
 #include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#	define MACE__TRANSFORM_SSE 1
+#	include <xmmintrin.h>
+#endif
 /*
 The MIT License (MIT)
 
@@ -100,6 +105,70 @@ namespace mc {
 
 		return orthoMatrix;
 	}
+	Matrix<float, 4, 4> math::compose(const Vector<float, 3>& translation, const Vector<float, 3>& rotation, const Vector<float, 3>& scale) {
+		Matrix<float, 4, 4> out = identity<float, 4>();
+
+		//most transformations are not rotated, so the trigonometry can be skipped
+		if (rotation[0] == 0.0f && rotation[1] == 0.0f && rotation[2] == 0.0f) {
+			for (Index i = 0; i < 3; ++i) {
+				out[i][i] = scale[i];
+				out[3][i] = translation[i];
+			}
+
+			return out;
+		}
+
+		const float cosZ = std::cos(rotation[2]), sinZ = std::sin(rotation[2]);
+		const float cosY = std::cos(rotation[1]), sinY = std::sin(rotation[1]);
+		const float cosX = std::cos(rotation[0]), sinX = std::sin(rotation[0]);
+
+		//the columns of the rotation are the same as the mat3 that the shaders used to build
+		const float rotationMatrix[3][3] = {
+			{ cosZ * cosY, -sinZ, sinY },
+			{ sinZ, cosZ * cosX, -sinX },
+			{ -sinY, sinX, cosX * cosY }
+		};
+
+		for (Index i = 0; i < 3; ++i) {
+			for (Index j = 0; j < 3; ++j) {
+				out[i][j] = scale[i] * rotationMatrix[i][j];
+			}
+			out[3][i] = translation[i];
+		}
+
+		return out;
+	}
+	Matrix<float, 4, 4> math::multiply(const Matrix<float, 4, 4>& left, const Matrix<float, 4, 4>& right) {
+#ifdef MACE__TRANSFORM_SSE
+		float leftData[16], rightData[16];
+		left.flatten(leftData);
+		right.flatten(rightData);
+
+		const __m128 rightRows[4] = {
+			_mm_loadu_ps(rightData),
+			_mm_loadu_ps(rightData + 4),
+			_mm_loadu_ps(rightData + 8),
+			_mm_loadu_ps(rightData + 12)
+		};
+
+		//each row of the product is the rows of the right matrix weighted by a row of the left matrix
+		float out[4][4];
+		for (Index i = 0; i < 4; ++i) {
+			const float* leftRow = leftData + i * 4;
+
+			__m128 row = _mm_mul_ps(_mm_set1_ps(leftRow[0]), rightRows[0]);
+			row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(leftRow[1]), rightRows[1]));
+			row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(leftRow[2]), rightRows[2]));
+			row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(leftRow[3]), rightRows[3]));
+
+			_mm_storeu_ps(out[i], row);
+		}
+
+		return Matrix<float, 4, 4>(out);
+#else
+		return left * right;
+#endif
+	}
 	TransformMatrix::TransformMatrix() {
 		translation = { 0,0,0 };
 		rotation = { 0,0,0 };
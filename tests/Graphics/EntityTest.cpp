@@ -10,6 +10,7 @@ The above copyright notice and this permission notice shall be included in all c
 #include <Catch.hpp>
 #include <MACE/Graphics/Entity.h>
 #include <MACE/Graphics/Entity2D.h>
+#include <MACE/Graphics/Renderer.h>
 
 
 namespace mc {
@@ -46,6 +47,12 @@ namespace mc {
 			virtual void onClean() override {
 				isCleaned = true;
 			}
+
+			virtual void onEvent(Event& e) override {
+				receivedEvents.push_back(e.phase);
+			}
+		public:
+			std::vector<Event::Phase> receivedEvents;
 		};
 
 		class DummyGroup: public mc::gfx::Group {
@@ -110,6 +117,29 @@ namespace mc {
 				REQUIRE_FALSE(e.getProperty(Entity::DIRTY));
 				REQUIRE(e.isCleaned);
 			}
+
+			SECTION("Testing makeResizeDependentsDirty()") {
+				DummyEntity maintained = DummyEntity();
+				DummyEntity unaffected = DummyEntity();
+
+				e.reset();
+				e.addChild(maintained);
+				e.addChild(unaffected);
+
+				maintained.setProperty(Entity::MAINTAIN_WIDTH, true);
+
+				maintained.setProperty(Entity::DIRTY, false);
+				unaffected.setProperty(Entity::DIRTY, false);
+				e.setProperty(Entity::DIRTY, false);
+
+				e.makeResizeDependentsDirty();
+
+				REQUIRE(maintained.getProperty(Entity::DIRTY));
+				REQUIRE_FALSE(unaffected.getProperty(Entity::DIRTY));
+				REQUIRE(e.getProperty(Entity::DIRTY));
+
+				e.reset();
+			}
 		}
 
 		TEST_CASE("Testing the getParent() function", "[entity][graphics]") {
@@ -364,5 +394,111 @@ namespace mc {
 
 			c.reset();
 		}
+
+		TEST_CASE("Testing event dispatch", "[entity][graphics]") {
+			DummyEntity parent = DummyEntity();
+			DummyEntity target = DummyEntity();
+
+			parent.addChild(target);
+
+			Event e = Event();
+			e.type = Event::PRESS;
+			e.target = &target;
+
+			SECTION("Unsubscribed entities are skipped") {
+				EventRouter::dispatch(e);
+
+				REQUIRE(parent.receivedEvents.empty());
+				REQUIRE(target.receivedEvents.empty());
+			}
+
+			SECTION("Capture, target, and bubble phases") {
+				parent.subscribe(Event::PRESS, true);
+				parent.subscribe(Event::PRESS);
+				target.subscribe(Event::PRESS | Event::RELEASE);
+
+				EventRouter::dispatch(e);
+
+				REQUIRE(parent.receivedEvents.size() == 2);
+				REQUIRE(parent.receivedEvents[0] == Event::Phase::CAPTURE);
+				REQUIRE(parent.receivedEvents[1] == Event::Phase::BUBBLE);
+				REQUIRE(target.receivedEvents.size() == 1);
+				REQUIRE(target.receivedEvents[0] == Event::Phase::TARGET);
+			}
+
+			SECTION("Stopping propagation") {
+				parent.subscribe(Event::PRESS);
+				target.subscribe(Event::PRESS);
+
+				e.stopPropagation();
+				EventRouter::dispatch(e);
+
+				REQUIRE(parent.receivedEvents.empty());
+				REQUIRE(target.receivedEvents.empty());
+			}
+
+			parent.reset();
+		}
+
+		TEST_CASE("Testing subscriber counting", "[entity][graphics]") {
+			REQUIRE_FALSE(SubscriberCounter::hasSubscribers());
+
+			{
+				DummyEntity e = DummyEntity();
+
+				e.subscribe(Event::HOVER);
+				REQUIRE(SubscriberCounter::hasSubscribers());
+
+				e.unsubscribe(Event::HOVER);
+				REQUIRE_FALSE(SubscriberCounter::hasSubscribers());
+
+				e.subscribe(Event::PRESS, true);
+				REQUIRE(SubscriberCounter::hasSubscribers());
+			}
+
+			//destroying a subscribed entity removes it from the count
+			REQUIRE_FALSE(SubscriberCounter::hasSubscribers());
+
+			{
+				DummyEntity e = DummyEntity();
+
+				e.subscribe(Event::PRESS);
+				REQUIRE(SubscriberCounter::hasSubscribers());
+
+				//a reset entity can be reused, so it has to stop being counted right away
+				e.reset();
+				REQUIRE_FALSE(SubscriberCounter::hasSubscribers());
+
+				e.subscribe(Event::RELEASE);
+				REQUIRE(SubscriberCounter::hasSubscribers());
+			}
+
+			REQUIRE_FALSE(SubscriberCounter::hasSubscribers());
+		}
+
+		TEST_CASE("Testing render caching", "[entity][graphics]") {
+			DummyEntity e = DummyEntity();
+
+			REQUIRE_FALSE(e.isCached());
+
+			e.setCached(true);
+			REQUIRE(e.isCached());
+			REQUIRE(e.getProperty(Entity::DIRTY));
+
+			e.setCached(false);
+			REQUIRE_FALSE(e.isCached());
+		}
+
+		TEST_CASE("Testing parallel recording", "[entity][graphics]") {
+			DummyEntity e = DummyEntity();
+
+			REQUIRE_FALSE(e.isParallel());
+
+			e.setParallel(true);
+			REQUIRE(e.isParallel());
+
+			e.setParallel(false);
+			REQUIRE_FALSE(e.isParallel());
+		}
 	}
 }
\ No newline at end of file
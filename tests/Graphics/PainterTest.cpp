@@ -0,0 +1,210 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2016 Liav Turkia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+#include <Catch.hpp>
+#include <MACE/Graphics/Entity2D.h>
+#include <MACE/Graphics/Renderer.h>
+
+namespace mc {
+	namespace gfx {
+		class CountingPainterImpl: public PainterImpl {
+		public:
+			CountingPainterImpl(Painter* const p) : PainterImpl(p) {}
+
+			Size draws = 0;
+
+			void init() override {}
+			void destroy() override {}
+
+			void begin() override {}
+			void end() override {}
+
+			void clean() override {}
+		protected:
+			void loadSettings(const Painter::State&, const Painter::StateFields) override {}
+			void bindTexture(const Texture&, const Enums::TextureSlot) override {}
+
+			void draw(const Model&, const Enums::Brush, const Enums::RenderFeatures) override {
+				++draws;
+			}
+
+			void drawInstanced(const Model&, const Enums::Brush, const Enums::RenderFeatures, const InstanceData*, const Size) override {
+				++draws;
+			}
+		};
+
+		class CountingEntity: public GraphicsEntity {
+		public:
+			CountingEntity(const EntityID id) : impl(std::make_shared<CountingPainterImpl>(&getPainter())) {
+				//initializing the painter needs a renderer context, so it is given an implementation instead
+				getPainter().setImpl(impl, id);
+				setProperty(Entity::INIT, true);
+			}
+
+			//bring protected members in public for testing purposes
+			using Entity::render;
+
+			std::shared_ptr<CountingPainterImpl> impl;
+			Size renders = 0;
+		protected:
+			void onRender(Painter& p) override {
+				++renders;
+
+				p.draw(Model(), Enums::Brush::COLOR, Enums::RenderFeatures::DEFAULT);
+			}
+
+			void onUpdate() override {}
+			void onInit() override {}
+			void onDestroy() override {}
+		};
+
+		TEST_CASE("Testing painter replaying", "[painter][graphics]") {
+			CountingEntity parent(1), child(2);
+			parent.addChild(child);
+
+			parent.render();
+
+			REQUIRE(parent.renders == 1);
+			REQUIRE(child.renders == 1);
+			REQUIRE(child.impl->draws == 1);
+
+			SECTION("Entities that didn't change are replayed") {
+				parent.render();
+
+				REQUIRE(parent.renders == 1);
+				REQUIRE(child.renders == 1);
+				//the recorded draws are still drawn
+				REQUIRE(child.impl->draws == 2);
+			}
+
+			SECTION("Making an entity dirty records it again") {
+				child.makeDirty();
+				parent.render();
+
+				REQUIRE(parent.renders == 1);
+				REQUIRE(child.renders == 2);
+				REQUIRE(child.impl->draws == 2);
+			}
+
+			SECTION("Cleaning a parent without moving it doesn't record the children again") {
+				parent.makeDirty();
+				parent.render();
+
+				REQUIRE(parent.renders == 2);
+				REQUIRE(child.renders == 1);
+			}
+
+			SECTION("Moving a parent records it's children again") {
+				const Size revision = child.getRevision();
+
+				parent.translate(0.5f, 0.0f);
+				parent.render();
+
+				//the child itself wasn't changed, only where it is
+				REQUIRE(child.getRevision() == revision);
+				REQUIRE(parent.renders == 2);
+				REQUIRE(child.renders == 2);
+			}
+		}
+
+		TEST_CASE("Testing painter state saving", "[painter][graphics]") {
+			Image image = Image();
+			Painter& painter = image.getPainter();
+			//the non-const getters count as changing the state, so everything is checked through this
+			const Painter& state = painter;
+
+			const Painter::State defaultState = Painter::State();
+
+			SECTION("Nested pushes changing different fields") {
+				painter.setForegroundColor(Colors::RED);
+
+				painter.push();
+				painter.setForegroundColor(Colors::GREEN);
+				painter.setData(1.0f, 2.0f, 3.0f, 4.0f);
+
+				painter.push();
+				painter.setMaskTransform({ 0.5f, 0.5f, 0.25f, 0.25f });
+				painter.translate(0.5f, 0.0f, 0.0f);
+				painter.setData(5.0f, 6.0f, 7.0f, 8.0f);
+
+				REQUIRE(state.getForegroundColor() == Colors::GREEN);
+				REQUIRE(state.getData() == Vector<float, 4>({ 5.0f, 6.0f, 7.0f, 8.0f }));
+
+				painter.pop();
+
+				REQUIRE(state.getForegroundColor() == Colors::GREEN);
+				REQUIRE(state.getData() == Vector<float, 4>({ 1.0f, 2.0f, 3.0f, 4.0f }));
+				REQUIRE(state.getMaskTransform() == defaultState.maskTransform);
+				REQUIRE(state.getTransformation() == defaultState.transformation);
+
+				painter.pop();
+
+				REQUIRE(state.getForegroundColor() == Colors::RED);
+				REQUIRE(state.getData() == defaultState.data);
+			}
+
+			SECTION("Changing a field twice in one push") {
+				painter.setOpacity(0.5f);
+				const Matrix<float, 4, 4> filter = state.getFilter();
+
+				painter.push();
+				painter.setOpacity(0.25f);
+				painter.setFilter(1.0f, 0.0f, 0.0f, 1.0f);
+				painter.pop();
+
+				REQUIRE(state.getOpacity() == 0.5f);
+				REQUIRE(state.getFilter() == filter);
+
+				//the first value was the only one saved, so nothing is left over for the next push
+				painter.push();
+				painter.setForegroundColor(Colors::BLUE);
+				painter.pop();
+
+				REQUIRE(state.getFilter() == filter);
+				REQUIRE(state.getForegroundColor() == defaultState.foregroundColor);
+			}
+
+			SECTION("Changing every field") {
+				painter.setBackgroundColor(Colors::WHITE);
+
+				painter.push();
+				painter.getState().backgroundColor = Colors::BLUE;
+				painter.getState().transformation.scale(2.0f, 2.0f, 1.0f);
+				painter.setBackgroundColor(Colors::RED);
+				painter.pop();
+
+				REQUIRE(state.getBackgroundColor() == Colors::WHITE);
+				REQUIRE(state.getTransformation() == defaultState.transformation);
+			}
+
+			SECTION("State versions") {
+				const Size original = state.getStateVersion();
+
+				//nothing is saved until it changes
+				painter.push();
+				REQUIRE(state.getStateVersion() == original);
+
+				painter.setForegroundColor(Colors::BLUE);
+				const Size changed = state.getStateVersion();
+				REQUIRE(changed > original);
+
+				//the restored fields are changed again, so the version has to move forward instead of going back
+				painter.pop();
+				REQUIRE(state.getStateVersion() > changed);
+				REQUIRE(state.getForegroundColor() == defaultState.foregroundColor);
+
+#ifdef MACE_DEBUG_CHECK_ARGS
+				REQUIRE_THROWS(painter.pop());
+#endif
+			}
+
+			image.reset();
+		}
+	}
+}
@@ -0,0 +1,60 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2016 Liav Turkia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+#include <Catch.hpp>
+#include <MACE/Graphics/Particles.h>
+
+namespace mc {
+	namespace gfx {
+		TEST_CASE("Testing particle simulation", "[particles][graphics]") {
+			ParticleEmitter emitter(10);
+			emitter.setLifetime(1.0f, 1.0f);
+
+			SECTION("Emitting is capped by the capacity") {
+				emitter.emit(4);
+				REQUIRE(emitter.getParticleCount() == 4);
+
+				emitter.emit(20);
+				REQUIRE(emitter.getParticleCount() == 10);
+
+				emitter.clear();
+				REQUIRE(emitter.getParticleCount() == 0);
+			}
+
+			SECTION("Particles expire after their lifetime") {
+				emitter.emit(7);
+
+				emitter.simulate(0.5f);
+				REQUIRE(emitter.getParticleCount() == 7);
+
+				emitter.simulate(0.6f);
+				REQUIRE(emitter.getParticleCount() == 0);
+			}
+
+			SECTION("The emission rate spawns particles over time") {
+				emitter.setEmissionRate(4.0f);
+
+				emitter.simulate(0.5f);
+				REQUIRE(emitter.getParticleCount() == 2);
+
+				emitter.simulate(0.125f);
+				REQUIRE(emitter.getParticleCount() == 2);
+
+				emitter.simulate(0.125f);
+				REQUIRE(emitter.getParticleCount() == 3);
+			}
+
+			SECTION("Reducing the capacity kills particles") {
+				emitter.emit(8);
+				emitter.setCapacity(5);
+				REQUIRE(emitter.getParticleCount() == 5);
+			}
+		}
+	}
+}
@@ -0,0 +1,148 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2016 Liav Turkia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+#include <Catch.hpp>
+#include <MACE/Graphics/Scene.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace mc {
+	namespace gfx {
+		TEST_CASE("Testing scene serialization", "[scene][graphics]") {
+			const std::string path = "MACE-SceneTest.mcs";
+
+			Group root = Group();
+			Group parent = Group();
+			Group child = Group();
+			AlignmentComponent alignment = AlignmentComponent(Enums::VerticalAlign::TOP, Enums::HorizontalAlign::RIGHT);
+
+			parent.setX(0.5f);
+			parent.setWidth(0.25f);
+			parent.setProperty(Entity::MAINTAIN_X, true);
+			child.setY(-0.75f);
+			child.addComponent(alignment);
+
+			root.addChild(parent);
+			parent.addChild(child);
+
+			SceneWriter writer = SceneWriter();
+			writer.write(root, path);
+
+			Scene scene;
+			scene.load(path);
+
+			REQUIRE(scene.size() == 2);
+			REQUIRE(scene.getRoot().size() == 1);
+
+			const Entity& loadedParent = scene.getRoot().getChild(0);
+			REQUIRE(loadedParent.getX() == 0.5f);
+			REQUIRE(loadedParent.getWidth() == 0.25f);
+			REQUIRE(loadedParent.getProperty(Entity::MAINTAIN_X));
+			REQUIRE(loadedParent.size() == 1);
+
+			const Entity& loadedChild = loadedParent.getChild(0);
+			REQUIRE(loadedChild.getY() == -0.75f);
+			REQUIRE(loadedChild.getComponents().size() == 1);
+
+			scene.clear();
+			REQUIRE(scene.size() == 0);
+			REQUIRE(scene.getRoot().isEmpty());
+
+			root.reset();
+			parent.reset();
+
+			std::remove(path.c_str());
+		}
+
+		TEST_CASE("Testing corrupted scene files", "[scene][graphics]") {
+			const std::string path = "MACE-CorruptedSceneTest.mcs";
+
+			Group root = Group();
+			Group first = Group();
+			Group second = Group();
+			AlignmentComponent alignment = AlignmentComponent(Enums::VerticalAlign::TOP, Enums::HorizontalAlign::RIGHT);
+
+			second.addComponent(alignment);
+
+			root.addChild(first);
+			root.addChild(second);
+
+			SceneWriter writer = SceneWriter();
+			writer.write(root, path);
+
+			std::vector<char> original;
+			{
+				std::ifstream in = std::ifstream(path, std::ios::in | std::ios::binary);
+				original.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+			}
+
+			SceneFormat::Header header;
+			std::memcpy(&header, original.data(), sizeof(SceneFormat::Header));
+
+			const Size firstRecord = header.entityOffset;
+			const Size secondRecord = header.entityOffset + sizeof(SceneFormat::EntityRecord);
+
+			std::vector<char> corrupted = original;
+			const auto rewrite = [&] () {
+				std::ofstream out = std::ofstream(path, std::ios::out | std::ios::binary | std::ios::trunc);
+				out.write(corrupted.data(), static_cast<std::streamsize>(corrupted.size()));
+			};
+
+			Scene scene;
+
+			SECTION("Records that don't match the type counts") {
+				//the total stays the same, but there is 1 group less than there are group records
+				header.typeCounts[static_cast<Index>(Enums::SceneEntityType::GROUP)] -= 1;
+				header.typeCounts[static_cast<Index>(Enums::SceneEntityType::IMAGE)] += 1;
+				std::memcpy(corrupted.data(), &header, sizeof(SceneFormat::Header));
+				rewrite();
+
+				REQUIRE_THROWS_AS(scene.load(path), BadFileError);
+			}
+
+			SECTION("Entities sharing components") {
+				SceneFormat::EntityRecord record;
+				std::memcpy(&record, original.data() + secondRecord, sizeof(SceneFormat::EntityRecord));
+
+				//copy the component range of the second entity to the first one
+				SceneFormat::EntityRecord firstCopy;
+				std::memcpy(&firstCopy, original.data() + firstRecord, sizeof(SceneFormat::EntityRecord));
+				firstCopy.firstComponent = record.firstComponent;
+				firstCopy.componentCount = record.componentCount;
+				std::memcpy(corrupted.data() + firstRecord, &firstCopy, sizeof(SceneFormat::EntityRecord));
+				rewrite();
+
+				REQUIRE_THROWS_AS(scene.load(path), BadFileError);
+			}
+
+			SECTION("State properties are ignored") {
+				SceneFormat::EntityRecord record;
+				std::memcpy(&record, original.data() + firstRecord, sizeof(SceneFormat::EntityRecord));
+				record.properties |= Entity::DEAD | Entity::INIT | Entity::DIRTY;
+				std::memcpy(corrupted.data() + firstRecord, &record, sizeof(SceneFormat::EntityRecord));
+				rewrite();
+
+				scene.load(path);
+
+				REQUIRE(scene.size() == 2);
+				REQUIRE_FALSE(scene.getRoot().getChild(0).getProperty(Entity::DEAD));
+				REQUIRE_FALSE(scene.getRoot().getChild(0).getProperty(Entity::INIT));
+			}
+
+			scene.clear();
+			root.reset();
+
+			std::remove(path.c_str());
+		}
+	}
+}
@@ -0,0 +1,89 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2016 Liav Turkia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+#include <Catch.hpp>
+#include <MACE/Graphics/TileMap.h>
+
+namespace mc {
+	namespace gfx {
+		TEST_CASE("Testing tile maps", "[tilemap][graphics]") {
+			TileMap map(40, 20, 2, 16);
+
+			REQUIRE(map.getColumns() == 40);
+			REQUIRE(map.getRows() == 20);
+			REQUIRE(map.getLayerCount() == 2);
+			//partial chunks at the edges still count
+			REQUIRE(map.getChunkCount() == 6);
+
+			SECTION("Setting and getting tiles") {
+				REQUIRE(map.getTile(0, 0) == TileMap::EMPTY);
+
+				map.setTile(3, 4, 7);
+				map.setTile(3, 4, 9, 1);
+				map.setTile(39, 19, 2);
+
+				REQUIRE(map.getTile(3, 4) == 7);
+				REQUIRE(map.getTile(3, 4, 1) == 9);
+				REQUIRE(map.getTile(4, 3) == TileMap::EMPTY);
+				REQUIRE(map.getTile(39, 19) == 2);
+				REQUIRE(map.getTile(39, 19, 1) == TileMap::EMPTY);
+			}
+
+			SECTION("Filling a layer") {
+				map.fill(5, 1);
+
+				REQUIRE(map.getTile(0, 0, 1) == 5);
+				REQUIRE(map.getTile(39, 19, 1) == 5);
+				REQUIRE(map.getTile(0, 0) == TileMap::EMPTY);
+			}
+
+			SECTION("Resizing clears every tile") {
+				map.setTile(1, 1, 3);
+
+				map.resize(10, 10);
+
+				REQUIRE(map.getColumns() == 10);
+				REQUIRE(map.getRows() == 10);
+				REQUIRE(map.getLayerCount() == 1);
+				REQUIRE(map.getChunkCount() == 1);
+				REQUIRE(map.getTile(1, 1) == TileMap::EMPTY);
+			}
+
+			SECTION("Only changes make the map dirty") {
+				const Size revision = map.getRevision();
+
+				map.setTile(2, 2, 1);
+				REQUIRE(map.getRevision() != revision);
+
+				const Size changed = map.getRevision();
+
+				//the tile is already set, so nothing has to be rebuilt
+				map.setTile(2, 2, 1);
+				REQUIRE(map.getRevision() == changed);
+
+				map.setAtlasSize(4, 4);
+				REQUIRE(map.getRevision() != changed);
+				REQUIRE(map.getAtlasColumns() == 4);
+				REQUIRE(map.getAtlasRows() == 4);
+			}
+
+#ifdef MACE_DEBUG_CHECK_ARGS
+			SECTION("Tiles outside of the map") {
+				REQUIRE_THROWS(map.getTile(40, 0));
+				REQUIRE_THROWS(map.getTile(0, 20));
+				REQUIRE_THROWS(map.getTile(0, 0, 2));
+				REQUIRE_THROWS(map.setTile(40, 0, 1));
+				REQUIRE_THROWS(map.fill(1, 2));
+				REQUIRE_THROWS(map.setAtlasSize(0, 1));
+				REQUIRE_THROWS(TileMap(1, 1, 1, 0));
+			}
+#endif
+		}
+	}
+}
@@ -16,6 +16,29 @@ namespace mc {
 			}
 		}
 
+		TEST_CASE("Testing composed transformations", "[utility][vector]") {
+			SECTION("Composing without rotation") {
+				Matrix4f m = compose({ 1, 2, 3 }, { 0, 0, 0 }, { 4, 5, 6 });
+				REQUIRE(m[0][0] == 4);
+				REQUIRE(m[1][1] == 5);
+				REQUIRE(m[2][2] == 6);
+				REQUIRE(m[3][0] == 1);
+				REQUIRE(m[3][1] == 2);
+				REQUIRE(m[3][2] == 3);
+				REQUIRE(m[3][3] == 1);
+			}
+			SECTION("Multiplying") {
+				Matrix4f left = compose({ 1, 2, 3 }, { 0.3f, 0.5f, 0.7f }, { 2, 3, 4 });
+				Matrix4f right = compose({ -1, 0.5f, 3 }, { 0.1f, -0.5f, 1.7f }, { 1, 2, 0.5f });
+				Matrix4f product = multiply(left, right), expected = left * right;
+				for (Index x = 0; x < 4; ++x) {
+					for (Index y = 0; y < 4; ++y) {
+						REQUIRE(product[x][y] == Approx(expected[x][y]));
+					}
+				}
+			}
+		}
+
 		TEST_CASE("Testing transformation class", "[utility][vector]") {
 			TransformMatrix t = TransformMatrix();
 			SECTION("Testing default values") {